@@ -0,0 +1,156 @@
+#pragma once
+
+#include "dom/Node.hpp"
+#include "layout/RenderTree.hpp"
+#include "render/MSDFFont.hpp"
+#include "style/StyleSheet.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace skene {
+
+// Lays out whole render trees on a background thread. The main thread keeps
+// painting and hit-testing its current tree while a new one is built (say, for
+// a new window size), then swaps the finished tree in between frames.
+//
+// The worker reads the live DOM, so the DOM must not change while a request is
+// in flight - cancel() first. It lays out against its own copy of the style
+// sheet, and fonts it loads are uploaded to the GPU on first use by the main
+// thread (MSDFFont::deferGPUUpload).
+//
+// Only whole-tree layouts come here. Incremental passes - style edits, and the
+// time slices that finish deferred and content-visibility:auto content - run on
+// the main thread against the tree it paints; they're bounded by relayout
+// boundaries and the slice budget.
+class LayoutWorker {
+public:
+  explicit LayoutWorker(MSDFFontManager *fontManager) : fontManager(fontManager) {
+    thread = std::thread([this] { run(); });
+  }
+
+  ~LayoutWorker() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+      cancelled = true;
+    }
+    wake.notify_all();
+    thread.join();
+  }
+
+  LayoutWorker(const LayoutWorker &) = delete;
+  LayoutWorker &operator=(const LayoutWorker &) = delete;
+
+  // Lay out dom for a viewport. Replaces a request that hasn't started yet; one
+  // already running finishes first, so a stream of requests (live resize) still
+  // produces trees.
+  void request(std::shared_ptr<Node> dom, const StyleSheet &styleSheet, float width,
+               float height, float scrollY) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending = std::make_unique<Request>(Request{std::move(dom), styleSheet, width, height, scrollY});
+      cancelled = false;
+    }
+    wake.notify_all();
+  }
+
+  // The newest finished tree, or null if none was finished since the last call
+  std::shared_ptr<RenderTree> takeResult() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::move(result);
+  }
+
+  // A request is queued, being laid out, or finished and not yet taken
+  bool busy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending || running || result;
+  }
+
+  // Drop queued and finished work, and wait for a running layout to stop, so the
+  // DOM can be changed. The layout polls the flag box by box (RenderTree::
+  // abortFlag), so this waits for one box at most, not a whole pass.
+  void cancel() {
+    std::unique_lock<std::mutex> lock(mutex);
+    pending.reset();
+    result.reset();
+    cancelled = true;
+    idle.wait(lock, [this] { return !running; });
+  }
+
+  // Destroy a replaced tree here instead of on the main thread
+  void retire(std::shared_ptr<RenderTree> tree) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      retired.push_back(std::move(tree));
+    }
+    wake.notify_all();
+  }
+
+private:
+  struct Request {
+    std::shared_ptr<Node> dom;
+    StyleSheet styleSheet;
+    float width, height, scrollY;
+  };
+
+  void run() {
+    MSDFFont::deferGPUUpload = true;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      wake.wait(lock, [this] { return stopping || pending || !retired.empty(); });
+      if (stopping) break;
+      if (!retired.empty()) {
+        auto trees = std::move(retired);
+        retired.clear();
+        lock.unlock();
+        trees.clear();
+        lock.lock();
+        continue;
+      }
+      auto job = std::move(pending);
+      running = true;
+      lock.unlock();
+      auto tree = layout(*job);
+      job.reset();
+      lock.lock();
+      running = false;
+      if (tree && !cancelled) result = std::move(tree);
+      idle.notify_all();
+    }
+  }
+
+  // Build and lay out a whole tree. Passes aren't time-sliced here (nothing
+  // waits on them); more follow while content-visibility:auto content near the
+  // viewport is pending. A cancelled tree is abandoned mid-pass.
+  std::shared_ptr<RenderTree> layout(Request &job) {
+    auto tree = std::make_shared<RenderTree>();
+    tree->viewportHeight = job.height;
+    tree->abortFlag = &cancelled;
+    tree->buildAndLayout(job.dom, job.width, job.styleSheet, fontManager);
+    do {
+      if (cancelled) return nullptr;
+      tree->relayout(job.width, job.height, job.styleSheet, fontManager, job.scrollY);
+    } while (tree->hasPendingLayout());
+    if (cancelled) return nullptr;
+    tree->abortFlag = nullptr;  // The main thread lays it out from here on
+    return tree;
+  }
+
+  MSDFFontManager *fontManager;
+  std::thread thread;
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  std::unique_ptr<Request> pending;
+  std::shared_ptr<RenderTree> result;
+  std::vector<std::shared_ptr<RenderTree>> retired;
+  std::atomic<bool> cancelled{false};
+  bool running = false;
+  bool stopping = false;
+};
+
+} // namespace skene
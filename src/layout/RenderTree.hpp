@@ -4,8 +4,14 @@
 #include "render/MSDFFont.hpp"
 #include "style/StyleSheet.hpp"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -13,11 +19,47 @@
 
 namespace skene {
 
+// Fixed-point layout length: 1/64 px in an int32 (about +-33M px). Layout math
+// itself is float, but a box is laid out at its inputs snapped to LayoutUnits,
+// and those are its cache keys: float rounding noise can't cause a miss, any
+// real change of 1/64 px or more is one, and cached subtrees move by exact amounts.
+struct LayoutUnit {
+  static constexpr int32_t SCALE = 64;
+  int32_t raw = 0;
+
+  static LayoutUnit fromPx(float px) {
+    double scaled = std::round(static_cast<double>(px) * SCALE);
+    scaled = std::clamp(scaled, static_cast<double>(std::numeric_limits<int32_t>::min()),
+                        static_cast<double>(std::numeric_limits<int32_t>::max()));
+    return LayoutUnit{static_cast<int32_t>(scaled)};
+  }
+  float toPx() const { return static_cast<float>(raw) / SCALE; }
+
+  LayoutUnit operator-(LayoutUnit other) const { return LayoutUnit{raw - other.raw}; }
+  LayoutUnit &operator+=(LayoutUnit other) {
+    raw += other.raw;
+    return *this;
+  }
+  bool operator==(const LayoutUnit &other) const = default;
+  bool operator<(LayoutUnit other) const { return raw < other.raw; }
+  bool operator>=(LayoutUnit other) const { return raw >= other.raw; }
+};
+
 struct Rect {
   float x = 0, y = 0, width = 0, height = 0;
 
   float right() const { return x + width; }
   float bottom() const { return y + height; }
+
+  // Smallest rect containing both. Zero-size rects (empty boxes) don't count.
+  Rect united(const Rect &other) const {
+    if (other.width <= 0 && other.height <= 0) return *this;
+    if (width <= 0 && height <= 0) return other;
+    float left = std::min(x, other.x);
+    float top = std::min(y, other.y);
+    return Rect{left, top, std::max(right(), other.right()) - left,
+                std::max(bottom(), other.bottom()) - top};
+  }
 };
 
 // Box model dimensions
@@ -79,8 +121,11 @@ struct TextSelection {
   // -1 means not set, will be calculated on first up/down press
   float goalX = -1.0f;
   
-  // Document-order list of all text boxes (rebuilt each frame)
+  // Document-order list of the laid-out text boxes. Each box knows its own
+  // position (RenderBox::textBoxIndex), so lookups don't search the list.
+  // Replaced through setTextBoxes whenever RenderTree::textBoxGeneration moves on.
   std::vector<std::shared_ptr<class RenderBox>> allTextBoxes;
+  uint64_t textBoxGeneration = 0;
   
   void clear() {
     anchorBox = nullptr;
@@ -117,19 +162,21 @@ struct TextSelection {
     isSelecting = false;
   }
   
-  // Get index of a box in the document order (-1 if not found)
-  int getBoxIndex(std::shared_ptr<class RenderBox> box) const {
-    for (size_t i = 0; i < allTextBoxes.size(); ++i) {
-      if (allTextBoxes[i].get() == box.get()) {
-        return static_cast<int>(i);
-      }
-    }
-    return -1;
-  }
+  // Replace the text box list and number its boxes (defined after RenderBox)
+  void setTextBoxes(std::vector<std::shared_ptr<class RenderBox>> boxes, uint64_t generation);
+
+  // Replace the listed text boxes of one subtree (tree order range
+  // [treeOrder, treeOrderEnd)) with boxes, renumbering only what moved
+  void replaceTextBoxes(uint32_t treeOrder, uint32_t treeOrderEnd,
+                        std::vector<std::shared_ptr<class RenderBox>> boxes);
+
+  // Get index of a box in the document order (-1 if not found). O(1): the box's
+  // own index is checked against the list, so boxes from an older list or tree miss.
+  int getBoxIndex(const std::shared_ptr<class RenderBox> &box) const;
   
   // Check if a box is within the selection range
   // Returns: -1 = before selection, 0 = within selection, 1 = after selection
-  int getBoxSelectionState(std::shared_ptr<class RenderBox> box) const {
+  int getBoxSelectionState(const std::shared_ptr<class RenderBox> &box) const {
     if (!hasSelection || !anchorBox || !focusBox) return -1;
     
     int boxIdx = getBoxIndex(box);
@@ -147,7 +194,7 @@ struct TextSelection {
   }
   
   // Check if this is the start box of the selection
-  bool isStartBox(std::shared_ptr<class RenderBox> box) const {
+  bool isStartBox(const std::shared_ptr<class RenderBox> &box) const {
     if (!hasSelection) return false;
     int anchorIdx = getBoxIndex(anchorBox);
     int focusIdx = getBoxIndex(focusBox);
@@ -161,7 +208,7 @@ struct TextSelection {
   }
   
   // Check if this is the end box of the selection
-  bool isEndBox(std::shared_ptr<class RenderBox> box) const {
+  bool isEndBox(const std::shared_ptr<class RenderBox> &box) const {
     if (!hasSelection) return false;
     int anchorIdx = getBoxIndex(anchorBox);
     int focusIdx = getBoxIndex(focusBox);
@@ -177,7 +224,7 @@ struct TextSelection {
   // Get selection range for a specific box
   // Returns (startChar, endChar) for the given line, or (-1, -1) if not selected
   std::pair<size_t, size_t> getSelectionRangeForLine(
-      std::shared_ptr<class RenderBox> box, size_t lineIdx, size_t lineLength) const {
+      const std::shared_ptr<class RenderBox> &box, size_t lineIdx, size_t lineLength) const {
     
     int state = getBoxSelectionState(box);
     if (state != 0) return {0, 0};  // Not in selection
@@ -230,9 +277,24 @@ struct TextSelection {
   }
 };
 
+// The font a computed style's text is drawn in (the default font if its
+// families don't load). Resolved once and remembered in the style, so text
+// paths don't look the family list up again until the font registry changes.
+inline MSDFFont *fontForStyle(MSDFFontManager *fontManager, const StyleSheet::ComputedStyle &style) {
+  uint64_t generation = fontManager->getGeneration();
+  auto &resolved = style.resolvedFont;
+  if (resolved.font && resolved.generation == generation) return resolved.font;
+  MSDFFont *font = fontManager->getFont(style.fontFamily, static_cast<int>(style.fontWeight),
+                                        static_cast<int>(style.fontStyle));
+  if (!font) font = fontManager->getDefaultFont();
+  resolved = {font, generation};
+  return font;
+}
+
 class RenderBox : public std::enable_shared_from_this<RenderBox> {
 public:
   std::shared_ptr<Node> node;
+  std::string tag;       // Lower-cased tag name (empty for non-elements)
   Rect frame;            // Legacy - for compatibility
   BoxDimensions box;     // Full box model
   StyleSheet::ComputedStyle computedStyle;
@@ -247,24 +309,133 @@ public:
     size_t startIndex = 0;  // Character offset in original text
   };
   std::vector<TextLine> textLines;
+  int textBoxIndex = -1;  // Position in TextSelection::allTextBoxes (checked on lookup)
+  // Preorder position in the tree, and one past its last descendant's. Set by
+  // RenderTree::build; the tree's shape never changes after that.
+  uint32_t treeOrder = 0;
+  uint32_t treeOrderEnd = 0;
   
   // Text layout cache - avoid expensive rewrapping
-  float lastTextLayoutWidth = -1.0f;
+  LayoutUnit lastTextLayoutWidth = LayoutUnit::fromPx(-1.0f);
   float lastTextLayoutHeight = 0.0f;
 
-  // Scroll state for overflow:scroll/auto elements
+  // Scroll state for overflow:scroll/auto elements. Change it with scrollTo.
   float scrollX = 0.0f;
   float scrollY = 0.0f;
+  // Moves on whenever any box's scroll offset changes, so what's placed by
+  // scroll offsets (RenderTree::paintLayers) knows to place it again
+  static inline std::atomic<uint64_t> scrollGeneration{0};
   float scrollableWidth = 0.0f;   // Content width beyond container
   float scrollableHeight = 0.0f;  // Content height beyond container
+
+  // Overflow rects, kept current by layout (bottom-up) and shiftPosition.
+  // scrollableOverflow: border box plus everything descendants paint;
+  // visualOverflow: what this subtree paints - just the border box if this box
+  // clips its children or they aren't laid out.
+  Rect scrollableOverflow;
+  Rect visualOverflow;
+  // Children's visual overflow runs top to bottom (tops and bottoms both
+  // non-decreasing), as in block flow - paint can binary search it
+  bool childOverflowSorted = false;
   
   // Layout cache - skip recalc if nothing changed
-  float lastLayoutX = -999999.0f;
-  float lastLayoutY = -999999.0f;
-  float lastLayoutWidth = -1.0f;
+  LayoutUnit lastLayoutX = LayoutUnit::fromPx(-999999.0f);
+  LayoutUnit lastLayoutY = LayoutUnit::fromPx(-999999.0f);
+  LayoutUnit lastLayoutWidth = LayoutUnit::fromPx(-1.0f);  // Negative until first laid out
   bool layoutCacheValid = false;
-  bool usedFastPath = false;  // True if this element used position-shift only (was off-screen)
-  
+  bool styleResolved = false; // computedStyle has been computed from the stylesheet at least once
+
+  // Containment state (contain / content-visibility)
+  bool contentSkipped = false;            // Children weren't laid out (content-visibility)
+  bool subtreeHasLazyContent = false;     // Skipped content-visibility:auto content at or below this box
+  float rememberedContentHeight = -1.0f;  // Last laid-out content height (contain-intrinsic-size: auto)
+
+  // Time-sliced layout: a deferred box kept its old geometry (moved to its new
+  // position) or got an empty placeholder, and is laid out by a later slice
+  bool layoutDeferred = false;
+  bool subtreeHasDeferredLayout = false;  // This box or a descendant was deferred
+
+  // Positioned and translucent boxes are painted as layers, in stacking order
+  // rather than tree order (see RenderTree::stackingContexts). Fixed and sticky
+  // ones are laid out once; scrolling only moves them when composited.
+  bool subtreeHasPaintLayer = false;  // This box or a descendant is a paint layer
+  int paintLayerIndex = -1;           // Position in RenderTree::paintLayers (layers only)
+  int stackingContextIndex = -1;      // Position in RenderTree::stackingContexts, or -1
+
+  // State of the current layout pass, shared by every box it visits. RenderTree
+  // sets it up before each pass and reads back what was left over for the next
+  // one (see RenderTree::hasPendingLayout).
+  struct LayoutPassState {
+    int lazyBudget;        // content-visibility:auto subtrees left to lay out outside the viewport
+    bool lazyPending;      // Some nearby auto content was skipped for lack of budget
+    bool timeSliced;       // Off-screen block subtrees may be deferred to a later slice
+    bool viewportFirst;    // Defer every dirty off-screen subtree (first sweep of a slice)
+    std::chrono::steady_clock::time_point deadline;
+    bool deferredPending;  // Some subtree was deferred
+    bool madeProgress;     // A deferrable subtree was laid out after the viewport sweep
+    bool geometryChanged;  // Some box was laid out again or moved
+    bool textBoxesChanged; // Some text box gained or lost its lines, or had its subtree skipped or deferred
+    bool paintOrderChanged; // Some box's position, z-index, opacity or display changed, or a subtree was skipped or deferred
+    std::vector<RenderBox *> textBoxChanges;  // Subtrees whose text boxes changed
+    const std::atomic<bool> *abort;  // Set by another thread to stop the pass, or null
+
+    // Stop now? The pass is being abandoned along with its tree, so boxes
+    // return without laying out and what's left unfinished doesn't matter
+    bool aborted() const {
+      return abort && abort->load(std::memory_order_relaxed);
+    }
+
+    void textBoxesChangedUnder(RenderBox *subtree) {
+      textBoxesChanged = true;
+      textBoxChanges.push_back(subtree);
+    }
+
+    // Defer deferrable work now? Past the deadline, but only once the slice has
+    // laid out at least one subtree, so every slice makes progress
+    bool outOfTime() const {
+      return viewportFirst ||
+             (madeProgress && std::chrono::steady_clock::now() >= deadline);
+    }
+  };
+  // One per thread: passes on the layout worker (LayoutWorker.hpp) don't
+  // disturb the main thread's
+  static inline thread_local LayoutPassState layoutPass{};
+
+  // Intrinsic size cache - max-content width of this subtree (no line breaks
+  // at all), keyed by the font and size it was measured with. Cleared through
+  // the layout dirty bits.
+  float cachedMaxContentWidth = 0.0f;
+  MSDFFont* intrinsicCacheFont = nullptr;
+  float intrinsicCacheFontSize = -1.0f;
+  bool intrinsicSizesValid = false;
+  float cachedTableIntrinsicWidth = -1.0f;  // measureTableIntrinsicWidth result (-1 = not cached)
+  MSDFFont* tableIntrinsicCacheFont = nullptr;
+  float tableIntrinsicCacheFontSize = -1.0f;
+
+  // Table cache (display:table boxes only) - row/cell/col structure and the
+  // natural auto-layout column widths, so untouched tables skip re-measuring
+  std::vector<std::shared_ptr<RenderBox>> tableRows;
+  std::vector<std::vector<std::shared_ptr<RenderBox>>> tableCellsByRow;
+  std::vector<std::shared_ptr<RenderBox>> tableColumns;  // <col> elements in order
+  bool tableStructureValid = false;
+  std::vector<float> cachedColumnWidths;
+  LayoutUnit columnWidthsBasis = LayoutUnit::fromPx(-1.0f);  // Table content width they were measured at
+  bool columnWidthsDependOnWidth = false;  // A cell uses percentage padding
+  bool columnWidthsValid = false;
+
+  // Flex item cache - this box's flex base size (and flex-grow) as an item of a
+  // flex container, keyed by the font it was measured with. Cleared with the
+  // intrinsic size cache; the item's own layout cache covers its final size.
+  struct FlexItemMeasure {
+    float baseSize = 0.0f;  // Main-axis size before free space is distributed
+    float flexGrow = 0.0f;
+  };
+  FlexItemMeasure cachedFlexMeasure;
+  MSDFFont* flexMeasureFont = nullptr;
+  float flexMeasureFontSize = -1.0f;
+  bool flexMeasureIsRow = true;
+  bool flexMeasureValid = false;
+
   // Returns true if this element has scrollable overflow
   bool isScrollable() const {
     return (computedStyle.overflow == Overflow::Scroll || computedStyle.overflow == Overflow::Auto) &&
@@ -275,23 +446,65 @@ public:
   float maxScrollX() const { return std::max(0.0f, scrollableWidth); }
   float maxScrollY() const { return std::max(0.0f, scrollableHeight); }
   
-  // Clamp scroll to valid range
-  void clampScroll() {
-    scrollX = std::max(0.0f, std::min(scrollX, maxScrollX()));
-    scrollY = std::max(0.0f, std::min(scrollY, maxScrollY()));
+  bool isFixedPosition() const {
+    return node && node->type == NodeType::Element && computedStyle.position == Position::Fixed;
+  }
+  bool isStickyPosition() const {
+    return node && node->type == NodeType::Element && computedStyle.position == Position::Sticky;
+  }
+  // Painted and hit-tested in its own layer, at an offset that depends on scroll
+  bool isComposited() const { return isFixedPosition() || isStickyPosition(); }
+  // Painted after the normal flow of its stacking context, in z-order
+  bool isPaintLayer() const {
+    return node && node->type == NodeType::Element &&
+           (computedStyle.position != Position::Static || computedStyle.opacity < 1.0f);
   }
+  // A paint layer that orders its own positioned descendants
+  bool createsStackingContext() const {
+    if (!isPaintLayer()) return false;
+    return isComposited() || computedStyle.opacity < 1.0f || !computedStyle.zIndexAuto;
+  }
+
+  // Set the computed style, noting changes that reorder painting (see
+  // isPaintLayer; display:none drops a subtree's layers)
+  void setComputedStyle(const StyleSheet::ComputedStyle &style) {
+    const auto &old = computedStyle;
+    if (style.position != old.position || style.zIndex != old.zIndex ||
+        style.zIndexAuto != old.zIndexAuto || (style.opacity < 1.0f) != (old.opacity < 1.0f) ||
+        (style.display == DisplayType::Hidden) != (old.display == DisplayType::Hidden)) {
+      layoutPass.paintOrderChanged = true;
+    }
+    computedStyle = style;
+  }
+
+  // top/right/bottom/left in px (auto counts as 0; "0" parses as unit None)
+  static float insetPx(const CssValue &inset, float basis, float fontSize,
+                       float viewportWidth, float viewportHeight) {
+    if (inset.isAuto() || inset.unit == CssUnit::None) return 0.0f;
+    return inset.toPx(basis, fontSize, viewportWidth, viewportHeight);
+  }
+
+  // Scroll to (x, y), clamped to the valid range
+  void scrollTo(float x, float y) {
+    x = std::max(0.0f, std::min(x, maxScrollX()));
+    y = std::max(0.0f, std::min(y, maxScrollY()));
+    if (x == scrollX && y == scrollY) return;
+    scrollX = x;
+    scrollY = y;
+    scrollGeneration.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Clamp scroll to valid range
+  void clampScroll() { scrollTo(scrollX, scrollY); }
   
-  // Shift position of this element and all descendants (used for off-screen optimization)
-  // Shift position of this element and all descendants (used for off-screen optimization)
-  // Also marks all shifted elements as needing full layout when they become visible
+  // Shift position of this element and all descendants (used when a clean
+  // subtree only moved, e.g. because a sibling above it changed height)
   void shiftPosition(float deltaX, float deltaY) {
+    layoutPass.geometryChanged = true;
     box.content.x += deltaX;
     box.content.y += deltaY;
-    lastLayoutX += deltaX;
-    lastLayoutY += deltaY;
-    
-    // Mark this element as having used the fast path
-    usedFastPath = true;
+    lastLayoutX += LayoutUnit::fromPx(deltaX);
+    lastLayoutY += LayoutUnit::fromPx(deltaY);
     
     // Shift text lines
     for (auto& line : textLines) {
@@ -302,154 +515,279 @@ public:
     // Update frame
     frame.x += deltaX;
     frame.y += deltaY;
+
+    scrollableOverflow.x += deltaX;
+    scrollableOverflow.y += deltaY;
+    visualOverflow.x += deltaX;
+    visualOverflow.y += deltaY;
     
-    // Recursively shift children (they also get marked as usedFastPath)
+    // Recursively shift children (skipped content has no geometry to move).
+    // Fixed children are placed against the viewport and stay put.
+    if (contentSkipped || (layoutDeferred && lastLayoutWidth < LayoutUnit())) return;
     for (auto& child : children) {
-      if (child) child->shiftPosition(deltaX, deltaY);
+      if (child && !child->isFixedPosition()) child->shiftPosition(deltaX, deltaY);
     }
   }
   
+  // Recompute the overflow rects from the border box and the children's
+  // (already current) visual overflow. Layout code that positions a box by
+  // hand, not through layout(), calls this afterwards.
+  void updateOverflow() {
+    if (styleResolved && computedStyle.display == DisplayType::Hidden) {
+      scrollableOverflow = visualOverflow = Rect{frame.x, frame.y, 0, 0};
+      return;
+    }
+    Rect borderBox = box.borderBox();
+    scrollableOverflow = borderBox;
+    childOverflowSorted = true;
+    if (childrenLaidOut()) {
+      const Rect *previous = nullptr;
+      for (auto &child : children) {
+        const Rect &overflow = child->visualOverflow;
+        if (previous && (overflow.y < previous->y || overflow.bottom() < previous->bottom())) {
+          childOverflowSorted = false;
+        }
+        previous = &overflow;
+        if (child->isFixedPosition()) continue;  // Positioned against the viewport instead
+        scrollableOverflow = scrollableOverflow.united(overflow);
+      }
+    }
+    bool clipsChildren = computedStyle.overflow != Overflow::Visible ||
+                         computedStyle.containPaint || !childrenLaidOut();
+    visualOverflow = clipsChildren ? borderBox : scrollableOverflow;
+  }
+
   // Invalidate layout cache for this node and all descendants
   void invalidateLayoutCache() {
     layoutCacheValid = false;
+    invalidateIntrinsicSizes();
+    invalidateTableCache();
     for (auto& child : children) {
       if (child) child->invalidateLayoutCache();
     }
   }
-  
-  // Clear fast path flag for this node and all descendants (used when parent does full layout)
-  void clearFastPathRecursive() {
-    usedFastPath = false;
-    for (auto& child : children) {
-      if (child) child->clearFastPathRecursive();
+
+  // Drop cached intrinsic widths for this node only
+  void invalidateIntrinsicSizes() {
+    intrinsicSizesValid = false;
+    cachedTableIntrinsicWidth = -1.0f;
+    flexMeasureValid = false;
+  }
+
+  // Mark this node dirty after a content change. Ancestors size themselves from
+  // their descendants, so their layout and intrinsic caches are dropped too - up
+  // to the nearest relayout boundary. Returns the box relayout has to restart
+  // from: that boundary, or the root.
+  std::shared_ptr<RenderBox> markNeedsLayout() {
+    layoutCacheValid = false;
+    invalidateIntrinsicSizes();
+    invalidateTableCache();
+    auto parentBox = parent.lock();
+    if (!parentBox || isRelayoutBoundary()) {
+      return shared_from_this();
     }
+    return parentBox->markNeedsLayout();
   }
 
-  RenderBox(std::shared_ptr<Node> n) : node(n) {}
+  // A relayout boundary's size doesn't depend on its contents and its overflow
+  // stays inside it, so relaying out its subtree can't move anything outside:
+  // a fixed width and height with overflow hidden/scroll/auto, or contain: size
+  // layout. Its parent must place it as a plain block child - flex, table and
+  // inline layout adjust children after laying them out.
+  bool isRelayoutBoundary() const {
+    if (!styleResolved || node->type != NodeType::Element) return false;
+    const auto &style = computedStyle;
+    bool sizeContained = style.containSize && style.containLayout;
+    if (!sizeContained && (style.overflow == Overflow::Visible || !hasFixedLengthSize())) {
+      return false;
+    }
+    if (style.display != DisplayType::Block && style.display != DisplayType::Flex) {
+      return false;
+    }
+    auto parentBox = parent.lock();
+    if (!parentBox) return false;
+    DisplayType parentDisplay = parentBox->computedStyle.display;
+    return parentDisplay == DisplayType::Block ||
+           parentDisplay == DisplayType::InlineBlock ||
+           parentDisplay == DisplayType::TableCell;
+  }
 
-  void addChild(std::shared_ptr<RenderBox> child) {
-    children.push_back(child);
-    child->parent = weak_from_this();
+  // Width and height are both absolute lengths (no auto, percentages or viewport units)
+  bool hasFixedLengthSize() const {
+    auto isFixedLength = [](const CssValue &v) {
+      return (v.unit == CssUnit::Px || v.unit == CssUnit::Em || v.unit == CssUnit::Rem) &&
+             v.value >= 0;
+    };
+    return isFixedLength(computedStyle.width) && isFixedLength(computedStyle.height);
   }
 
-  // Helper: find the maximum right edge of all descendant content
-  // Stops recursion at children that have their own overflow handling
-  float findMaxDescendantRight() const {
-    float maxRight = box.borderBox().right();
-    for (const auto& child : children) {
-      if (!child) continue;
-      
-      // If child has its own overflow handling, don't look at its children
-      // (they'll be clipped/scrolled within the child)
-      bool childHasOverflow = (
-        child->computedStyle.overflow == Overflow::Scroll ||
-        child->computedStyle.overflow == Overflow::Auto ||
-        child->computedStyle.overflow == Overflow::Hidden
-      );
-      
-      if (childHasOverflow) {
-        // Just use the child's border box, not its descendants
-        maxRight = std::max(maxRight, child->box.borderBox().right());
-      } else {
-        // Recurse into child's descendants
-        maxRight = std::max(maxRight, child->findMaxDescendantRight());
-      }
+  // computedStyle is current: resolved by a layout that hasn't been invalidated
+  // since (style changes go through invalidateLayoutCache)
+  bool hasCleanStyle() const { return styleResolved && layoutCacheValid; }
+
+  // Display type for the parent's layout decisions, without re-resolving the
+  // style of a clean child
+  DisplayType resolvedDisplay(StyleSheet &styleSheet) const {
+    return hasCleanStyle() ? computedStyle.display : styleSheet.computeStyle(*node).display;
+  }
+
+  // False if this box's children have no current geometry (skipped or deferred)
+  bool childrenLaidOut() const { return !contentSkipped && !layoutDeferred; }
+
+  // Time slicing: a block child that needs layout and lies entirely outside the
+  // viewport can be deferred - always during a slice's viewport-first sweep,
+  // after that once the slice is out of time
+  bool canDeferLayout(float y, float availableWidth, float viewportScrollY,
+                      float viewportHeight) const {
+    if (!layoutPass.timeSliced) return false;
+    bool needsLayout = !layoutCacheValid || LayoutUnit::fromPx(availableWidth) != lastLayoutWidth ||
+                       subtreeHasDeferredLayout;
+    if (!needsLayout) return false;
+    bool hasOldLayout = lastLayoutWidth >= LayoutUnit();
+    bool belowViewport = y > viewportScrollY + viewportHeight;
+    bool aboveViewport = hasOldLayout && y + (frame.bottom() - lastLayoutY.toPx()) < viewportScrollY;
+    return belowViewport || aboveViewport;
+  }
+
+  // Place a deferred box at (x, y) without laying it out: keep its old geometry
+  // if it has one, otherwise leave an empty placeholder
+  void deferLayout(float x, float y) {
+    LayoutUnit layoutX = LayoutUnit::fromPx(x);
+    LayoutUnit layoutY = LayoutUnit::fromPx(y);
+    if (lastLayoutWidth >= LayoutUnit()) {
+      shiftPosition((layoutX - lastLayoutX).toPx(), (layoutY - lastLayoutY).toPx());
+    } else {
+      box.content = {layoutX.toPx(), layoutY.toPx(), 0, 0};
+      frame = box.content;
+      lastLayoutX = layoutX;
+      lastLayoutY = layoutY;
+      layoutPass.geometryChanged = true;
+    }
+    if (childrenLaidOut()) {
+      layoutPass.textBoxesChangedUnder(this);
+      layoutPass.paintOrderChanged = true;
+    }
+    layoutDeferred = true;
+    subtreeHasDeferredLayout = true;
+    layoutPass.deferredPending = true;
+    updateOverflow();
+  }
+
+  // position: fixed - out of flow, laid out against the viewport at top/left
+  // (else its static position), as wide as left/right leave. The geometry is in
+  // page coordinates at scroll 0; the compositor adds the page scroll and
+  // anchors to right/bottom (fixedAnchorOffset), so neither needs layout.
+  void layoutFixed(float staticX, float staticY, const StyleSheet::ComputedStyle &style,
+                   StyleSheet &styleSheet, MSDFFontManager *fontManager,
+                   float viewportWidth, float viewportHeight) {
+    float fontSize = style.fontSize;
+    float left = insetPx(style.left, viewportWidth, fontSize, viewportWidth, viewportHeight);
+    float right = insetPx(style.right_, viewportWidth, fontSize, viewportWidth, viewportHeight);
+    float top = insetPx(style.top, viewportHeight, fontSize, viewportWidth, viewportHeight);
+
+    float x = style.left.isAuto() ? staticX : left;
+    float y = style.top.isAuto() ? staticY : top;
+    float width = std::max(0.0f, viewportWidth - left - right);
+    layout(x, y, width, styleSheet, fontManager, viewportWidth, viewportHeight, false, 0.0f);
+  }
+
+  // Move from where layoutFixed put a fixed box to its right/bottom anchor, for
+  // a box whose left/top is auto
+  std::pair<float, float> fixedAnchorOffset(float viewportWidth, float viewportHeight) const {
+    const auto &style = computedStyle;
+    float fontSize = style.fontSize;
+    Rect border = box.borderBox();
+    float dx = 0.0f, dy = 0.0f;
+    if (style.left.isAuto() && !style.right_.isAuto()) {
+      float right = insetPx(style.right_, viewportWidth, fontSize, viewportWidth, viewportHeight);
+      dx = viewportWidth - right - style.getMarginRight(viewportWidth, fontSize) - border.right();
+    }
+    if (style.top.isAuto() && !style.bottom.isAuto()) {
+      float bottom = insetPx(style.bottom, viewportHeight, fontSize, viewportWidth, viewportHeight);
+      dy = viewportHeight - bottom - style.getMarginBottom(viewportWidth, fontSize) - border.bottom();
+    }
+    return {dx, dy};
+  }
+
+  // True if [top, bottom] lies within one viewport height of the visible area
+  static bool isNearViewport(float top, float bottom, float viewportScrollY, float viewportHeight) {
+    return bottom >= viewportScrollY - viewportHeight &&
+           top <= viewportScrollY + 2.0f * viewportHeight;
+  }
+
+  // Placeholder content size for size-contained or skipped content, from
+  // contain-intrinsic-size. With "auto", skipped content keeps its last real height.
+  float containIntrinsicContentWidth(float viewportWidth, float viewportHeight) const {
+    const CssValue &w = computedStyle.containIntrinsicWidth;
+    if (w.isAuto()) return 0.0f;
+    return std::max(0.0f, w.toPx(0, computedStyle.fontSize, viewportWidth, viewportHeight));
+  }
+
+  float containIntrinsicContentHeight(bool skipped, float viewportWidth, float viewportHeight) const {
+    if (skipped && computedStyle.containIntrinsicSizeAuto && rememberedContentHeight >= 0) {
+      return rememberedContentHeight;
+    }
+    const CssValue &h = computedStyle.containIntrinsicHeight;
+    if (h.isAuto()) return 0.0f;
+    return std::max(0.0f, h.toPx(0, computedStyle.fontSize, viewportWidth, viewportHeight));
+  }
+
+  RenderBox(std::shared_ptr<Node> n) : node(n) {
+    if (node && node->type == NodeType::Element) {
+      tag = node->tagName;
+      std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
     }
-    return maxRight;
+  }
+
+  void addChild(std::shared_ptr<RenderBox> child) {
+    children.push_back(child);
+    child->parent = weak_from_this();
+    markNeedsLayout();  // Structure changed (e.g. a table row/cell was added)
   }
 
   // New layout with StyleSheet and FontManager support
-  // viewportScrollY: current scroll position (top of visible area)
-  // Elements below viewportScrollY + viewportHeight can use minimal layout
+  // viewportScrollY: current scroll position (top of visible area), used to
+  // decide which content-visibility:auto subtrees get laid out this pass
   void layout(float x, float y, float availableWidth, StyleSheet &styleSheet,
               MSDFFontManager *fontManager, float viewportWidth = 1024.0f,
               float viewportHeight = 768.0f, bool inInlineFlow = false,
               float viewportScrollY = 0.0f) {
-    
-    // Viewport-aware optimization: if this element starts below the viewport,
-    // and we have valid cached dimensions, skip full layout and reuse cached height
-    float viewportBottom = viewportScrollY + viewportHeight;
-    bool isBelowViewport = (y > viewportBottom);
-    bool isNowVisible = !isBelowViewport;
-    
-    // If element was previously off-screen (used fast path) and is now visible,
-    // force a full relayout to get accurate positioning
-    bool needsFullLayout = usedFastPath && isNowVisible;
-    
-    // If below viewport and we have cached dimensions, do minimal layout
-    if (isBelowViewport && lastLayoutWidth > 0 && box.content.height > 0 && !needsFullLayout) {
-      // Mark that we used the fast path (position shift only)
-      usedFastPath = true;
-      
-      // Just update position, reuse cached height
-      float deltaY = y - lastLayoutY;
-      float deltaX = x - lastLayoutX;
-      
-      // Update box positions
-      box.content.x += deltaX;
-      box.content.y = y + (box.content.y - lastLayoutY);
-      
-      // Update text line positions if any
-      for (auto& line : textLines) {
-        line.x += deltaX;
-        line.y += deltaY;
-      }
-      
-      // Update children positions recursively
-      for (auto& child : children) {
-        if (child) {
-          child->shiftPosition(deltaX, deltaY);
+    if (layoutPass.aborted()) return;
+    
+    // Snap position and width to LayoutUnits - they key the layout cache
+    LayoutUnit layoutX = LayoutUnit::fromPx(x);
+    LayoutUnit layoutY = LayoutUnit::fromPx(y);
+    LayoutUnit layoutWidth = LayoutUnit::fromPx(availableWidth);
+    x = layoutX.toPx();
+    y = layoutY.toPx();
+    availableWidth = layoutWidth.toPx();
+
+    // Layout cache: a clean subtree laid out at the same width only needs moving.
+    // Skipped content-visibility:auto content is re-examined once it nears the viewport.
+    if (layoutCacheValid && layoutWidth == lastLayoutWidth && !subtreeHasDeferredLayout) {
+      float deltaX = (layoutX - lastLayoutX).toPx();
+      float deltaY = (layoutY - lastLayoutY).toPx();
+      bool lazyContentNearby = subtreeHasLazyContent &&
+          isNearViewport(frame.y + deltaY, frame.bottom() + deltaY, viewportScrollY, viewportHeight);
+      if (!lazyContentNearby) {
+        if (deltaX != 0 || deltaY != 0) {
+          shiftPosition(deltaX, deltaY);
         }
+        return;
       }
-      
-      // Update cache
-      lastLayoutX = x;
-      lastLayoutY = y;
-      
-      // Frame was already set relative to margin box
-      float marginTop = computedStyle.getMarginTop(availableWidth, computedStyle.fontSize);
-      float marginBottom = computedStyle.getMarginBottom(availableWidth, computedStyle.fontSize);
-      float marginLeft = computedStyle.getMarginLeft(availableWidth, computedStyle.fontSize);
-      float marginRight = computedStyle.getMarginRight(availableWidth, computedStyle.fontSize);
-      frame = {box.content.x - marginLeft - computedStyle.getBorderLeftWidth() - computedStyle.getPaddingLeft(availableWidth, computedStyle.fontSize),
-               box.content.y - marginTop - computedStyle.getBorderTopWidth() - computedStyle.getPaddingTop(availableWidth, computedStyle.fontSize),
-               box.borderBox().width + marginLeft + marginRight,
-               box.borderBox().height + marginTop + marginBottom};
-      return;
-    }
-    
-    // Element is visible or needs full layout - clear the fast path flag
-    usedFastPath = false;
-    
-    // If we're doing a full layout because element came into view,
-    // clear fast path flags on all children so they also get full layout
-    if (needsFullLayout) {
-      for (auto& child : children) {
-        if (child) child->clearFastPathRecursive();
-      }
-    }
-    
-    // Layout cache optimization: skip full recalc if position and width unchanged
-    // This dramatically speeds up resize by avoiding redundant calculations
-    // But don't skip if element needs full layout (was off-screen, now visible)
-    if (layoutCacheValid && !needsFullLayout &&
-        x == lastLayoutX && 
-        y == lastLayoutY && 
-        availableWidth == lastLayoutWidth) {
-      // Position unchanged - just update children's Y positions if needed
-      // (they may have shifted due to siblings above them changing)
-      return;
     }
     
     // Cache current layout params
-    lastLayoutX = x;
-    lastLayoutY = y;
-    lastLayoutWidth = availableWidth;
+    layoutPass.geometryChanged = true;
+    lastLayoutX = layoutX;
+    lastLayoutY = layoutY;
+    lastLayoutWidth = layoutWidth;
     layoutCacheValid = true;
     
     // Compute style for this node
-    computedStyle = styleSheet.computeStyle(*node);
-    
+    setComputedStyle(styleSheet.computeStyle(*node));
+    styleResolved = true;
+
     // CSS Inheritance: Certain properties inherit from parent by default
     // This applies to both text nodes AND element nodes
     auto parentBox = parent.lock();
@@ -458,9 +796,7 @@ public:
       if (node->type == NodeType::Text) {
         computedStyle.color = parentBox->computedStyle.color;
         computedStyle.fontSize = parentBox->computedStyle.fontSize;
-        computedStyle.fontWeight = parentBox->computedStyle.fontWeight;
-        computedStyle.fontStyle = parentBox->computedStyle.fontStyle;
-        computedStyle.fontFamily = parentBox->computedStyle.fontFamily;
+        computedStyle.inheritFont(parentBox->computedStyle);
         computedStyle.textDecoration = parentBox->computedStyle.textDecoration;
         computedStyle.textAlign = parentBox->computedStyle.textAlign;
         computedStyle.lineHeight = parentBox->computedStyle.lineHeight;
@@ -493,6 +829,7 @@ public:
         bool fontFamilyExplicitlySet = inlineStyle.find("font-family") != std::string::npos;
         if (!fontFamilyExplicitlySet) {
           computedStyle.fontFamily = parentBox->computedStyle.fontFamily;
+          computedStyle.resolvedFont = {};
         }
         
         bool lineHeightExplicitlySet = inlineStyle.find("line-height") != std::string::npos;
@@ -505,15 +842,52 @@ public:
     auto &style = computedStyle;
 
     // Skip if display:none
+    bool childrenWereLaidOut = childrenLaidOut();
+    contentSkipped = false;
+    subtreeHasLazyContent = false;
+    layoutDeferred = false;
+    subtreeHasDeferredLayout = false;
+    subtreeHasPaintLayer = false;
     if (style.display == DisplayType::Hidden) {
+      if (!childrenWereLaidOut) {
+        layoutPass.textBoxesChangedUnder(this);
+        layoutPass.paintOrderChanged = true;
+      }
       frame = {x, y, 0, 0};
+      updateOverflow();
       return;
     }
+    subtreeHasPaintLayer = isPaintLayer();
+
+    // content-visibility: hidden never lays out its contents; auto lays them out
+    // when on screen, or when near the screen while this pass still has budget
+    if (node->type == NodeType::Element) {
+      if (style.contentVisibility == ContentVisibility::Hidden) {
+        contentSkipped = true;
+      } else if (style.contentVisibility == ContentVisibility::Auto) {
+        float estimatedBottom = y + containIntrinsicContentHeight(true, viewportWidth, viewportHeight);
+        bool onScreen = estimatedBottom >= viewportScrollY && y <= viewportScrollY + viewportHeight;
+        bool nearScreen = isNearViewport(y, estimatedBottom, viewportScrollY, viewportHeight);
+        if (!onScreen) {
+          if (nearScreen && layoutPass.lazyBudget > 0) {
+            --layoutPass.lazyBudget;
+          } else {
+            contentSkipped = true;
+            subtreeHasLazyContent = true;
+            if (nearScreen) layoutPass.lazyPending = true;
+          }
+        }
+      }
+    }
+    // Text boxes and layers below come into or drop out of selection's text box
+    // list and the stacking order
+    if (childrenLaidOut() != childrenWereLaidOut) {
+      layoutPass.textBoxesChangedUnder(this);
+      layoutPass.paintOrderChanged = true;
+    }
 
     // Get the correct font for this element's style
-    MSDFFont* font = fontManager->getFont(style.fontFamily, 
-        static_cast<int>(style.fontWeight), static_cast<int>(style.fontStyle));
-    if (!font) font = fontManager->getDefaultFont();
+    MSDFFont* font = fontForStyle(fontManager, style);
 
     float fontSize = style.fontSize;
     float parentWidth = availableWidth;
@@ -541,8 +915,6 @@ public:
     bool isCheckableInput = false;
     bool isCheckboxInput = false;
     if (node->type == NodeType::Element) {
-      std::string tag = node->tagName;
-      std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
       if (tag == "input") {
         auto typeIt = node->attributes.find("type");
         std::string inputType = "text";
@@ -598,7 +970,10 @@ public:
                style.display == DisplayType::InlineBlock ||
                style.display == DisplayType::Table) {
       // For tables, measure actual column widths
-      if (style.display == DisplayType::Table) {
+      if (style.containSize || contentSkipped) {
+        // Size containment: the contents don't contribute to our width
+        contentWidth = containIntrinsicContentWidth(viewportWidth, viewportHeight);
+      } else if (style.display == DisplayType::Table) {
         contentWidth = measureTableIntrinsicWidth(font, fontSize) - (paddingLeft + paddingRight + borderLeft + borderRight);
       } else {
         contentWidth = measureIntrinsicWidth(font, fontSize);
@@ -634,10 +1009,15 @@ public:
     // Layout children or text
     float contentHeight = 0;
 
-    if (node->type == NodeType::Text) {
+    if (contentSkipped) {
+      // Children keep their old (or no) geometry and aren't painted or hit-tested
+      contentHeight = containIntrinsicContentHeight(true, viewportWidth, viewportHeight);
+    } else if (node->type == NodeType::Text) {
       // Text node: perform text wrapping
+      bool hadLines = !textLines.empty();
       contentHeight =
           layoutText(contentStartX, contentStartY, contentWidth, font, style);
+      if (textLines.empty() == hadLines) layoutPass.textBoxesChangedUnder(this);
     } else if (style.display == DisplayType::Flex) {
       contentHeight = layoutFlexChildren(contentStartX, contentStartY,
                                          contentWidth, styleSheet, fontManager,
@@ -673,11 +1053,22 @@ public:
 
     // Store natural content height for scroll calculation
     float naturalContentHeight = contentHeight;
+
+    if (!contentSkipped && node->type != NodeType::Text) {
+      rememberedContentHeight = contentHeight;
+      for (auto &child : children) {
+        if (child->subtreeHasLazyContent) subtreeHasLazyContent = true;
+        if (child->subtreeHasDeferredLayout) subtreeHasDeferredLayout = true;
+        if (child->subtreeHasPaintLayer || child->isPaintLayer()) subtreeHasPaintLayer = true;
+      }
+      // Size containment: lay out the contents, but size as if there were none
+      if (style.containSize) {
+        contentHeight = containIntrinsicContentHeight(false, viewportWidth, viewportHeight);
+      }
+    }
     
     // Form elements: ensure minimum dimensions
     if (node->type == NodeType::Element) {
-      std::string tag = node->tagName;
-      std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
       if (tag == "input") {
         auto typeIt = node->attributes.find("type");
         std::string inputType = "text";
@@ -794,6 +1185,7 @@ public:
     }
 
     box.content.height = contentHeight;
+    updateOverflow();
     
     // Calculate scrollable area for overflow:scroll/auto elements
     if (style.overflow == Overflow::Scroll || style.overflow == Overflow::Auto) {
@@ -801,9 +1193,9 @@ public:
       float rawScrollableHeight = naturalContentHeight - contentHeight;
       scrollableHeight = rawScrollableHeight > 3.0f ? rawScrollableHeight : 0.0f;
       
-      // Calculate scrollable width: find the maximum width extent of ALL descendants
-      // (not just direct children) relative to content box
-      float maxDescendantRight = findMaxDescendantRight();
+      // Calculate scrollable width: the right edge of everything descendants
+      // paint, relative to the content box
+      float maxDescendantRight = scrollableOverflow.right();
       float contentLeft = box.content.x;
       float maxChildExtent = maxDescendantRight - contentLeft;
       
@@ -873,15 +1265,43 @@ public:
   }
 
 private:
+  // Max-content width of this subtree (cached, see measureMaxContentWidth)
   float measureIntrinsicWidth(MSDFFont *font, float fontSize) {
+    bool cacheable = true;
+    return measureMaxContentWidth(font, fontSize, cacheable);
+  }
+
+  // Measure the max-content width, reusing the cached result when this subtree
+  // hasn't been dirtied since it was last measured with the same font and size.
+  // cacheable is cleared if a box below hasn't resolved its style yet - such a
+  // result is provisional and must not be cached by any ancestor either.
+  float measureMaxContentWidth(MSDFFont *font, float fontSize, bool &cacheable) {
+    if (intrinsicSizesValid && intrinsicCacheFont == font && intrinsicCacheFontSize == fontSize) {
+      return cachedMaxContentWidth;
+    }
+
+    bool subtreeCacheable = true;
+    float width = computeMaxContentWidth(font, fontSize, subtreeCacheable);
+
+    if (subtreeCacheable) {
+      cachedMaxContentWidth = width;
+      intrinsicCacheFont = font;
+      intrinsicCacheFontSize = fontSize;
+      intrinsicSizesValid = true;
+    } else {
+      cacheable = false;
+    }
+    return width;
+  }
+
+  float computeMaxContentWidth(MSDFFont *font, float fontSize, bool &cacheable) {
     if (node->type == NodeType::Text && font) {
       return font->getTextWidth(node->textContent, fontSize);
     }
     
     // Form elements have minimum intrinsic widths
     if (node->type == NodeType::Element) {
-      std::string tag = node->tagName;
-      std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
+      float fixedWidth = -1.0f;
       if (tag == "input") {
         auto typeIt = node->attributes.find("type");
         std::string inputType = "text";
@@ -890,27 +1310,28 @@ private:
           std::transform(inputType.begin(), inputType.end(), inputType.begin(), ::tolower);
         }
         if (inputType == "checkbox" || inputType == "radio") {
-          return 16.0f + 4.0f;  // 16px checkbox + 4px right margin
+          fixedWidth = 16.0f + 4.0f;  // 16px checkbox + 4px right margin
+        } else {
+          fixedWidth = 150.0f;  // Default input width
         }
-        return 150.0f;  // Default input width
       }
       if (tag == "button") {
         // Button width based on text content or minimum
         float textWidth = 0;
         for (auto &child : children) {
-          textWidth += child->measureIntrinsicWidth(font, fontSize);
+          textWidth += child->measureMaxContentWidth(font, fontSize, cacheable);
         }
-        return std::max(textWidth, 40.0f);  // Minimum 40px
+        fixedWidth = std::max(textWidth, 40.0f);  // Minimum 40px
       }
       if (tag == "img") {
         // Use width attribute if specified, otherwise default
+        fixedWidth = 150.0f;  // Default placeholder width
         auto widthAttr = node->attributes.find("width");
         if (widthAttr != node->attributes.end()) {
           try {
-            return std::stof(widthAttr->second);
+            fixedWidth = std::stof(widthAttr->second);
           } catch (...) {}
         }
-        return 150.0f;  // Default placeholder width
       }
       if (tag == "textarea") {
         // Use cols attribute if specified
@@ -919,11 +1340,34 @@ private:
         if (colsAttr != node->attributes.end()) {
           try { cols = std::stoi(colsAttr->second); } catch (...) {}
         }
-        return cols * fontSize * 0.6f;  // Approximate char width
+        fixedWidth = cols * fontSize * 0.6f;  // Approximate char width
       }
       if (tag == "select") {
-        return 150.0f;  // Default select width
+        fixedWidth = 150.0f;  // Default select width
+      }
+      if (fixedWidth >= 0) return fixedWidth;
+    }
+
+    // Display and padding below come from our own style
+    if (!styleResolved) cacheable = false;
+
+    // Size containment: only contain-intrinsic-width contributes, not the contents
+    if (computedStyle.containSize || computedStyle.contentVisibility == ContentVisibility::Hidden) {
+      float placeholder = computedStyle.containIntrinsicWidth.isAuto() ? 0.0f :
+          std::max(0.0f, computedStyle.containIntrinsicWidth.toPx(0, computedStyle.fontSize));
+      return placeholder + computedStyle.getPaddingLeft() + computedStyle.getPaddingRight();
+    }
+
+    // Fixed-size relayout boundaries measure as their specified width, so a change
+    // inside one never has to re-measure the ancestors' contents
+    if (isRelayoutBoundary() && hasFixedLengthSize()) {
+      float width = computedStyle.width.toPx(0, computedStyle.fontSize);
+      if (computedStyle.boxSizing == BoxSizing::BorderBox) {
+        width -= computedStyle.getBorderLeftWidth() + computedStyle.getBorderRightWidth();
+      } else {
+        width += computedStyle.getPaddingLeft() + computedStyle.getPaddingRight();
       }
+      return std::max(0.0f, width);
     }
 
     // For block elements, use max width of children (they stack vertically)
@@ -936,63 +1380,29 @@ private:
     
     float padding = style.getPaddingLeft() + style.getPaddingRight();
     
-    if (isBlockElement) {
-      // Block elements: width is max of children (they stack vertically)
-      float maxWidth = 0;
-      for (auto &child : children) {
-        maxWidth = std::max(maxWidth, child->measureIntrinsicWidth(font, fontSize));
-      }
-      return maxWidth + padding;
-    } else {
-      // Inline/inline-block elements: sum widths (they flow horizontally)
-      float totalWidth = 0;
-      for (auto &child : children) {
-        totalWidth += child->measureIntrinsicWidth(font, fontSize);
+    float width = 0;
+    for (auto &child : children) {
+      float childWidth = child->measureMaxContentWidth(font, fontSize, cacheable);
+      if (isBlockElement) {
+        // Block elements: width is max of children (they stack vertically)
+        width = std::max(width, childWidth);
+      } else {
+        // Inline/inline-block elements: sum widths (they flow horizontally)
+        width += childWidth;
       }
-      return totalWidth + padding;
     }
+    return width + padding;
   }
 
   // Measure intrinsic width for tables by calculating column widths
   float measureTableIntrinsicWidth(MSDFFont *font, float fontSize) {
-    // Find all table rows (including through tbody/thead/tfoot)
-    std::vector<std::vector<std::shared_ptr<RenderBox>>> cellsByRow;
-    
-    for (auto& child : children) {
-      std::string tag = child->node->tagName;
-      std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
-      
-      // Handle tbody, thead, tfoot
-      if (tag == "tbody" || tag == "thead" || tag == "tfoot") {
-        for (auto& rowChild : child->children) {
-          std::string rowTag = rowChild->node->tagName;
-          std::transform(rowTag.begin(), rowTag.end(), rowTag.begin(), ::tolower);
-          if (rowTag == "tr") {
-            std::vector<std::shared_ptr<RenderBox>> cells;
-            for (auto& cellChild : rowChild->children) {
-              std::string cellTag = cellChild->node->tagName;
-              std::transform(cellTag.begin(), cellTag.end(), cellTag.begin(), ::tolower);
-              if (cellTag == "td" || cellTag == "th") {
-                cells.push_back(cellChild);
-              }
-            }
-            cellsByRow.push_back(cells);
-          }
-        }
-      }
-      // Direct TR children (no tbody)
-      else if (tag == "tr") {
-        std::vector<std::shared_ptr<RenderBox>> cells;
-        for (auto& cellChild : child->children) {
-          std::string cellTag = cellChild->node->tagName;
-          std::transform(cellTag.begin(), cellTag.end(), cellTag.begin(), ::tolower);
-          if (cellTag == "td" || cellTag == "th") {
-            cells.push_back(cellChild);
-          }
-        }
-        cellsByRow.push_back(cells);
-      }
+    if (cachedTableIntrinsicWidth >= 0 && tableIntrinsicCacheFont == font &&
+        tableIntrinsicCacheFontSize == fontSize) {
+      return cachedTableIntrinsicWidth;
     }
+
+    collectTableStructure();
+    const auto &cellsByRow = tableCellsByRow;
     
     if (cellsByRow.empty()) return 0;
     
@@ -1005,12 +1415,15 @@ private:
     if (numColumns == 0) return 0;
     
     // Measure all cells to determine column widths
+    // (only cached once every cell has resolved its padding/border style)
+    bool cacheable = styleResolved;
     std::vector<float> columnWidths(numColumns, 0);
     for (size_t rowIdx = 0; rowIdx < cellsByRow.size(); rowIdx++) {
       auto& rowCells = cellsByRow[rowIdx];
       for (size_t colIdx = 0; colIdx < rowCells.size(); colIdx++) {
         auto cell = rowCells[colIdx];
         auto& cellStyle = cell->computedStyle;
+        if (!cell->styleResolved) cacheable = false;
         float cellFontSize = cellStyle.fontSize;
         MSDFFont* cellFont = font;
         
@@ -1024,12 +1437,12 @@ private:
         // For text cells, measure just the text content (excluding padding)
         float cellContentWidth = 0;
         if (cell->node->type == NodeType::Text && cellFont) {
-          cellContentWidth = cellFont->getTextWidth(cell->node->textContent, cellFontSize);
+          cellContentWidth = cell->measureIntrinsicWidth(cellFont, cellFontSize);
         } else {
           // For non-text cells, use children's intrinsic width without their padding
           for (auto& child : cell->children) {
             if (child->node->type == NodeType::Text && cellFont) {
-              cellContentWidth += cellFont->getTextWidth(child->node->textContent, cellFontSize);
+              cellContentWidth += child->measureIntrinsicWidth(cellFont, cellFontSize);
             }
           }
         }
@@ -1050,7 +1463,13 @@ private:
     float tablePadding = style.getPaddingLeft() + style.getPaddingRight();
     float tableBorder = style.getBorderLeftWidth() + style.getBorderRightWidth();
     
-    return totalTableWidth + tablePadding + tableBorder;
+    float tableWidth = totalTableWidth + tablePadding + tableBorder;
+    if (cacheable) {
+      cachedTableIntrinsicWidth = tableWidth;
+      tableIntrinsicCacheFont = font;
+      tableIntrinsicCacheFontSize = fontSize;
+    }
+    return tableWidth;
   }
 
   float layoutText(float x, float y, float maxWidth, MSDFFont *font,
@@ -1071,7 +1490,8 @@ private:
     
     // Text layout cache: if width unchanged, just adjust Y positions
     // This dramatically speeds up resize when only Y positions change
-    if (!textLines.empty() && std::abs(maxWidth - lastTextLayoutWidth) < 1.0f) {
+    LayoutUnit wrapWidth = LayoutUnit::fromPx(maxWidth);
+    if (!textLines.empty() && wrapWidth == lastTextLayoutWidth) {
       // Width same - just shift Y positions
       float deltaY = y - textLines[0].y;
       if (std::abs(deltaY) > 0.001f) {
@@ -1084,7 +1504,7 @@ private:
     
     // Width changed - need to recalculate text wrapping
     textLines.clear();
-    lastTextLayoutWidth = maxWidth;
+    lastTextLayoutWidth = wrapWidth;
     
     float currentY = y;
 
@@ -1149,7 +1569,7 @@ private:
 
     for (size_t i = 0; i < words.size(); ++i) {
       const std::string &word = words[i];
-      float wordWidth = font->getTextWidth(word, fontSize);
+      float wordWidth = font->getWordWidth(word, fontSize);
 
       float testWidth = currentLineWidth + wordWidth;
 
@@ -1218,9 +1638,9 @@ private:
     int textNodeCount = 0;
     
     for (const auto &child : children) {
-      StyleSheet::ComputedStyle childStyle = styleSheet.computeStyle(*child->node);
-      bool isInlineElement = (childStyle.display == DisplayType::Inline ||
-                              childStyle.display == DisplayType::InlineBlock);
+      DisplayType childDisplay = child->resolvedDisplay(styleSheet);
+      bool isInlineElement = (childDisplay == DisplayType::Inline ||
+                              childDisplay == DisplayType::InlineBlock);
       bool isTextNode = (child->node->type == NodeType::Text);
       
       if (isInlineElement) {
@@ -1251,8 +1671,10 @@ private:
     while (i < children.size()) {
       auto &child = children[i];
       
-      // Compute style to determine display type
-      StyleSheet::ComputedStyle childStyle = styleSheet.computeStyle(*child->node);
+      // Compute style to determine display type (reused while the child is clean)
+      StyleSheet::ComputedStyle computedChildStyle;
+      const StyleSheet::ComputedStyle &childStyle = child->hasCleanStyle() ?
+          child->computedStyle : (computedChildStyle = styleSheet.computeStyle(*child->node));
       
       // Check if this child is inline or text
       bool isInlineElement = (childStyle.display == DisplayType::Inline ||
@@ -1265,9 +1687,9 @@ private:
         std::vector<size_t> inlineGroup;
         while (i < children.size()) {
           auto &c = children[i];
-          StyleSheet::ComputedStyle cStyle = styleSheet.computeStyle(*c->node);
-          bool isInline = (cStyle.display == DisplayType::Inline ||
-                           cStyle.display == DisplayType::InlineBlock ||
+          DisplayType cDisplay = c->resolvedDisplay(styleSheet);
+          bool isInline = (cDisplay == DisplayType::Inline ||
+                           cDisplay == DisplayType::InlineBlock ||
                            c->node->type == NodeType::Text);
           if (isInline) {
             inlineGroup.push_back(i);
@@ -1280,6 +1702,11 @@ private:
         currentY += layoutInlineGroup(inlineGroup, x, currentY, width, styleSheet,
                                      fontManager, viewportWidth, viewportHeight, viewportScrollY);
         prevMarginBottom = 0.0f;  // Reset after inline content
+      } else if (child->node->type == NodeType::Element && childStyle.position == Position::Fixed) {
+        // Out of flow: takes no space here
+        child->layoutFixed(x, currentY, childStyle, styleSheet, fontManager, viewportWidth,
+                           viewportHeight);
+        i++;
       } else {
         // Block element - apply CSS margin collapsing
         float childMarginTop = childStyle.getMarginTop(width, childStyle.fontSize);
@@ -1299,8 +1726,14 @@ private:
         // Fix: pass Y position for where the margin-box top should be
         float marginBoxY = currentY - prevMarginBottom + collapsedMargin - childMarginTop;
         
-        child->layout(x, marginBoxY, width, styleSheet, fontManager, viewportWidth,
-                     viewportHeight, false, viewportScrollY);
+        bool deferrable = child->canDeferLayout(marginBoxY, width, viewportScrollY, viewportHeight);
+        if (deferrable && layoutPass.outOfTime()) {
+          child->deferLayout(x, marginBoxY);
+        } else {
+          if (deferrable) layoutPass.madeProgress = true;
+          child->layout(x, marginBoxY, width, styleSheet, fontManager, viewportWidth,
+                       viewportHeight, false, viewportScrollY);
+        }
         
         // Move currentY to after this child's border box, then add its bottom margin
         Rect borderBox = child->box.borderBox();
@@ -1409,6 +1842,7 @@ private:
     std::vector<std::string> tokens = tokenizeForInlineLayout(text);
     
     // Clear text lines - we'll build them manually
+    bool hadLines = !child->textLines.empty();
     child->textLines.clear();
     
     std::string currentLineText;
@@ -1416,7 +1850,7 @@ private:
     
     for (size_t t = 0; t < tokens.size(); ++t) {
       const std::string &token = tokens[t];
-      float tokenWidth = font->getTextWidth(token, fontSize);
+      float tokenWidth = font->getWordWidth(token, fontSize);
       
       // Check if token fits on current line
       // Don't wrap before punctuation - it should stay at end of previous line
@@ -1505,6 +1939,8 @@ private:
       child->frame = {currentX, currentY, 0, 0};
       child->box.content = child->frame;
     }
+    if (child->textLines.empty() == hadLines) layoutPass.textBoxesChangedUnder(child.get());
+    child->updateOverflow();
   }
   
   // Helper to apply vertical-align adjustments to a line of inline elements
@@ -1556,10 +1992,13 @@ private:
             for (auto& tl : c->textLines) {
               tl.y += offset;
             }
+            c->scrollableOverflow.y += offset;
+            c->visualOverflow.y += offset;
             adjustChildren(c, offset);
           }
         };
         adjustChildren(child, yDelta);
+        child->updateOverflow();
       }
     }
   }
@@ -1581,8 +2020,7 @@ private:
       
       // Handle <br> element - force line break
       if (child->node->type == NodeType::Element) {
-        std::string tag = child->node->tagName;
-        std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
+        const std::string &tag = child->tag;
         if (tag == "br") {
           // Apply vertical-align to current line before breaking
           if (!currentLineIndices.empty()) {
@@ -1592,6 +2030,7 @@ private:
           // Force line break
           child->frame = {currentX, currentY, 0, maxLineHeight};
           child->box.content = child->frame;
+          child->updateOverflow();
           currentX = x;
           currentY += maxLineHeight;
           lineStartY = currentY;
@@ -1603,22 +2042,18 @@ private:
       // For text nodes, do word-level wrapping
       if (child->node->type == NodeType::Text) {
         // Compute style first to get font size
-        child->computedStyle = styleSheet.computeStyle(*child->node);
+        child->setComputedStyle(styleSheet.computeStyle(*child->node));
         auto parentBox = child->parent.lock();
         if (parentBox) {
           child->computedStyle.color = parentBox->computedStyle.color;
           child->computedStyle.fontSize = parentBox->computedStyle.fontSize;
-          child->computedStyle.fontWeight = parentBox->computedStyle.fontWeight;
-          child->computedStyle.fontStyle = parentBox->computedStyle.fontStyle;
-          child->computedStyle.fontFamily = parentBox->computedStyle.fontFamily;
+          child->computedStyle.inheritFont(parentBox->computedStyle);
           child->computedStyle.textDecoration = parentBox->computedStyle.textDecoration;
           child->computedStyle.textAlign = parentBox->computedStyle.textAlign;
           child->computedStyle.lineHeight = parentBox->computedStyle.lineHeight;
         }
         
-        MSDFFont* font = fontManager->getFont(child->computedStyle.fontFamily,
-            static_cast<int>(child->computedStyle.fontWeight), static_cast<int>(child->computedStyle.fontStyle));
-        if (!font) font = fontManager->getDefaultFont();
+        MSDFFont* font = fontForStyle(fontManager, child->computedStyle);
         
         if (font) {
           layoutTextTokensInline(child, child->node->textContent, currentX, currentY,
@@ -1628,7 +2063,7 @@ private:
       } else if (isInlineWithTextOnly(child)) {
         // Inline element with only text content (e.g., <code>, <strong>)
         // Tokenize and wrap the text, but apply the element's styling
-        child->computedStyle = styleSheet.computeStyle(*child->node);
+        child->setComputedStyle(styleSheet.computeStyle(*child->node));
         
         // Apply text alignment inheritance for inline elements
         // Check if text-align is explicitly set in inline style
@@ -1644,11 +2079,7 @@ private:
         
         // Only inherit font-size if the element doesn't have its own default size
         // (e.g., <code> has 13px default, should not inherit parent's 16px)
-        std::string tag = "";
-        if (child->node->type == NodeType::Element) {
-          tag = child->node->tagName;
-          std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
-        }
+        const std::string &tag = child->tag;
         bool hasOwnFontSize = (tag == "code" || tag == "pre" || tag == "kbd" || 
                                tag == "samp" || tag == "tt" || tag == "small" ||
                                tag == "sub" || tag == "sup" ||
@@ -1661,13 +2092,11 @@ private:
         
         // Get the text child
         auto &textChild = child->children[0];
-        textChild->computedStyle = styleSheet.computeStyle(*textChild->node);
+        textChild->setComputedStyle(styleSheet.computeStyle(*textChild->node));
         // Inherit styles from parent inline element
         textChild->computedStyle.color = child->computedStyle.color;
         textChild->computedStyle.fontSize = child->computedStyle.fontSize;
-        textChild->computedStyle.fontWeight = child->computedStyle.fontWeight;
-        textChild->computedStyle.fontStyle = child->computedStyle.fontStyle;
-        textChild->computedStyle.fontFamily = child->computedStyle.fontFamily;
+        textChild->computedStyle.inheritFont(child->computedStyle);
         textChild->computedStyle.textDecoration = child->computedStyle.textDecoration;
         textChild->computedStyle.textAlign = child->computedStyle.textAlign;
         textChild->computedStyle.lineHeight = child->computedStyle.lineHeight;
@@ -1683,9 +2112,7 @@ private:
         // Apply margin + border + padding before text
         currentX += marginLeft + borderLeft + paddingLeft;
         
-        MSDFFont* font = fontManager->getFont(textChild->computedStyle.fontFamily,
-            static_cast<int>(textChild->computedStyle.fontWeight), static_cast<int>(textChild->computedStyle.fontStyle));
-        if (!font) font = fontManager->getDefaultFont();
+        MSDFFont* font = fontForStyle(fontManager, textChild->computedStyle);
         
         std::string text = getInlineTextContent(child);
         if (font) {
@@ -1704,6 +2131,7 @@ private:
         child->box.margin = child->computedStyle.margin;
         // frame is the border box for compatibility
         child->frame = child->box.borderBox();
+        child->updateOverflow();
         
       } else {
         // Complex inline element - layout as a unit
@@ -1711,10 +2139,9 @@ private:
         // Pre-measure intrinsic width to avoid wrapping inside the element just
         // because we're near the end of the line (common for <label><input> text).
         StyleSheet::ComputedStyle preStyle = styleSheet.computeStyle(*child->node);
-        child->computedStyle = preStyle;
-        MSDFFont* preFont = fontManager->getFont(preStyle.fontFamily,
-            static_cast<int>(preStyle.fontWeight), static_cast<int>(preStyle.fontStyle));
-        if (!preFont) preFont = fontManager->getDefaultFont();
+        child->setComputedStyle(preStyle);
+        child->styleResolved = true;
+        MSDFFont* preFont = fontForStyle(fontManager, child->computedStyle);
         float idealWidth = child->measureIntrinsicWidth(preFont, preStyle.fontSize);
         float idealMarginLeft = preStyle.getMarginLeft(width, preStyle.fontSize);
         float idealMarginRight = preStyle.getMarginRight(width, preStyle.fontSize);
@@ -1767,6 +2194,7 @@ private:
           child->box.content.x = currentX + marginLeft + child->computedStyle.borderWidth.left.toPx() + 
                                  child->computedStyle.padding.left.toPx();
         }
+        child->updateOverflow();
         
         currentX += childBox.width;
         maxLineHeight = std::max(maxLineHeight, childBox.height);
@@ -1797,8 +2225,7 @@ private:
       auto &child = children[childIdx];
       // Handle <br> element - force line break
       if (child->node->type == NodeType::Element) {
-        std::string tag = child->node->tagName;
-        std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
+        const std::string &tag = child->tag;
         if (tag == "br") {
           // Apply vertical-align before line break
           if (!currentLineIndices.empty()) {
@@ -1808,6 +2235,7 @@ private:
           // Force line break
           child->frame = {currentX, currentY, 0, maxLineHeight};
           child->box.content = child->frame;
+          child->updateOverflow();
           currentX = x;
           currentY += maxLineHeight;
           lineStartY = currentY;
@@ -1819,22 +2247,18 @@ private:
       // For text nodes, do word-level wrapping
       if (child->node->type == NodeType::Text) {
         // Compute style first to get font size
-        child->computedStyle = styleSheet.computeStyle(*child->node);
+        child->setComputedStyle(styleSheet.computeStyle(*child->node));
         auto parentBox = child->parent.lock();
         if (parentBox) {
           child->computedStyle.color = parentBox->computedStyle.color;
           child->computedStyle.fontSize = parentBox->computedStyle.fontSize;
-          child->computedStyle.fontWeight = parentBox->computedStyle.fontWeight;
-          child->computedStyle.fontStyle = parentBox->computedStyle.fontStyle;
-          child->computedStyle.fontFamily = parentBox->computedStyle.fontFamily;
+          child->computedStyle.inheritFont(parentBox->computedStyle);
           child->computedStyle.textDecoration = parentBox->computedStyle.textDecoration;
           child->computedStyle.textAlign = parentBox->computedStyle.textAlign;
           child->computedStyle.lineHeight = parentBox->computedStyle.lineHeight;
         }
         
-        MSDFFont* font = fontManager->getFont(child->computedStyle.fontFamily,
-            static_cast<int>(child->computedStyle.fontWeight), static_cast<int>(child->computedStyle.fontStyle));
-        if (!font) font = fontManager->getDefaultFont();
+        MSDFFont* font = fontForStyle(fontManager, child->computedStyle);
         
         if (font) {
           layoutTextTokensInline(child, child->node->textContent, currentX, currentY,
@@ -1843,7 +2267,7 @@ private:
         
       } else if (isInlineWithTextOnly(child)) {
         // Inline element with only text content (e.g., <code>, <strong>)
-        child->computedStyle = styleSheet.computeStyle(*child->node);
+        child->setComputedStyle(styleSheet.computeStyle(*child->node));
         
         // Apply text alignment inheritance for inline elements
         // Check if text-align is explicitly set in inline style
@@ -1859,11 +2283,7 @@ private:
         
         // Only inherit font-size if the element doesn't have its own default size
         // (e.g., <code> has 13px default, should not inherit parent's 16px)
-        std::string tag = "";
-        if (child->node->type == NodeType::Element) {
-          tag = child->node->tagName;
-          std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
-        }
+        const std::string &tag = child->tag;
         bool hasOwnFontSize = (tag == "code" || tag == "pre" || tag == "kbd" || 
                                tag == "samp" || tag == "tt" || tag == "small" ||
                                tag == "sub" || tag == "sup" ||
@@ -1875,13 +2295,11 @@ private:
         
         // Get the text child
         auto &textChild = child->children[0];
-        textChild->computedStyle = styleSheet.computeStyle(*textChild->node);
+        textChild->setComputedStyle(styleSheet.computeStyle(*textChild->node));
         // Inherit styles from parent inline element
         textChild->computedStyle.color = child->computedStyle.color;
         textChild->computedStyle.fontSize = child->computedStyle.fontSize;
-        textChild->computedStyle.fontWeight = child->computedStyle.fontWeight;
-        textChild->computedStyle.fontStyle = child->computedStyle.fontStyle;
-        textChild->computedStyle.fontFamily = child->computedStyle.fontFamily;
+        textChild->computedStyle.inheritFont(child->computedStyle);
         textChild->computedStyle.textDecoration = child->computedStyle.textDecoration;
         textChild->computedStyle.textAlign = child->computedStyle.textAlign;
         textChild->computedStyle.lineHeight = child->computedStyle.lineHeight;
@@ -1897,9 +2315,7 @@ private:
         // Apply margin + border + padding before text
         currentX += marginLeft + borderLeft + paddingLeft;
         
-        MSDFFont* font = fontManager->getFont(textChild->computedStyle.fontFamily,
-            static_cast<int>(textChild->computedStyle.fontWeight), static_cast<int>(textChild->computedStyle.fontStyle));
-        if (!font) font = fontManager->getDefaultFont();
+        MSDFFont* font = fontForStyle(fontManager, textChild->computedStyle);
         
         std::string text = getInlineTextContent(child);
         if (font) {
@@ -1918,6 +2334,7 @@ private:
         child->box.margin = child->computedStyle.margin;
         // frame is the border box for compatibility
         child->frame = child->box.borderBox();
+        child->updateOverflow();
         
       } else {
         // Complex inline element - layout as a unit
@@ -1925,10 +2342,9 @@ private:
         // Same pre-measure logic as layoutInlineGroup: if the whole element
         // doesn't fit, move it to the next line before laying it out.
         StyleSheet::ComputedStyle preStyle = styleSheet.computeStyle(*child->node);
-        child->computedStyle = preStyle;
-        MSDFFont* preFont = fontManager->getFont(preStyle.fontFamily,
-            static_cast<int>(preStyle.fontWeight), static_cast<int>(preStyle.fontStyle));
-        if (!preFont) preFont = fontManager->getDefaultFont();
+        child->setComputedStyle(preStyle);
+        child->styleResolved = true;
+        MSDFFont* preFont = fontForStyle(fontManager, child->computedStyle);
         float idealWidth = child->measureIntrinsicWidth(preFont, preStyle.fontSize);
         float idealMarginLeft = preStyle.getMarginLeft(width, preStyle.fontSize);
         float idealMarginRight = preStyle.getMarginRight(width, preStyle.fontSize);
@@ -1984,41 +2400,67 @@ private:
     return (currentY - y) + maxLineHeight;
   }
 
+  // Measure this box as a flex item: its flex base size along the main axis
+  // (intrinsic width in a row, growing row items start from padding + border,
+  // column items are sized while positioning) and its flex-grow. Cached until
+  // the item is dirtied, unless a descendant's style wasn't resolved yet.
+  FlexItemMeasure measureFlexItem(bool isRow, StyleSheet &styleSheet, MSDFFontManager *fontManager) {
+    StyleSheet::ComputedStyle computedItemStyle;
+    const StyleSheet::ComputedStyle &itemStyle = hasCleanStyle() ?
+        computedStyle : (computedItemStyle = styleSheet.computeStyle(*node));
+
+    // Text items measure with the container's font
+    auto parentBox = parent.lock();
+    const StyleSheet::ComputedStyle &fontStyle =
+        (node->type == NodeType::Text && parentBox) ? parentBox->computedStyle : itemStyle;
+    MSDFFont* font = fontForStyle(fontManager, fontStyle);
+    float fontSize = fontStyle.fontSize;
+
+    if (flexMeasureValid && flexMeasureIsRow == isRow && flexMeasureFont == font &&
+        flexMeasureFontSize == fontSize) {
+      return cachedFlexMeasure;
+    }
+
+    FlexItemMeasure measure;
+    measure.flexGrow = itemStyle.flexGrow;
+    bool cacheable = true;
+    if (isRow) {
+      if (measure.flexGrow > 0) {
+        // For flex growing items, use minimal size
+        measure.baseSize = itemStyle.getPaddingLeft() + itemStyle.getPaddingRight() +
+                           itemStyle.getBorderLeftWidth() + itemStyle.getBorderRightWidth();
+      } else {
+        measure.baseSize = measureMaxContentWidth(font, fontSize, cacheable);
+      }
+    }
+
+    cachedFlexMeasure = measure;
+    flexMeasureFont = font;
+    flexMeasureFontSize = fontSize;
+    flexMeasureIsRow = isRow;
+    flexMeasureValid = cacheable;
+    return measure;
+  }
+
   float layoutFlexChildren(float x, float y, float width,
                            StyleSheet &styleSheet, MSDFFontManager *fontManager,
                            float viewportWidth, float viewportHeight,
                            float viewportScrollY = 0.0f) {
     auto &style = computedStyle;
-    bool isRow = (style.flexDirection == "row" ||
-                  style.flexDirection == "row-reverse");
-    bool canWrap = (style.flexWrap == "wrap" || style.flexWrap == "wrap-reverse");
+    bool isRow = (style.flexDirection == FlexDirection::Row ||
+                  style.flexDirection == FlexDirection::RowReverse);
+    bool canWrap = (style.flexWrap != FlexWrap::NoWrap);
     float gap = style.gap;
 
-    // First pass: measure intrinsic sizes of all children
+    // First pass: flex base sizes of all children (cached per item)
     std::vector<float> intrinsicSizes;
+    intrinsicSizes.reserve(children.size());
     float totalFlexGrow = 0;
     
     for (auto &child : children) {
-      MSDFFont* font = fontManager->getDefaultFont();
-      float fontSize = child->computedStyle.fontSize;
-      float intrinsicSize = 0;
-
-      if (isRow) {
-        if (child->computedStyle.flexGrow > 0) {
-          // For flex growing items, use minimal size
-          auto &childStyle = child->computedStyle;
-          float padding = childStyle.getPaddingLeft() + childStyle.getPaddingRight();
-          float border = childStyle.getBorderLeftWidth() + childStyle.getBorderRightWidth();
-          intrinsicSize = padding + border;
-        } else {
-          intrinsicSize = child->measureIntrinsicWidth(font, fontSize);
-        }
-      } else {
-        intrinsicSize = 0; // Column layout measures during positioning
-      }
-      
-      intrinsicSizes.push_back(intrinsicSize);
-      totalFlexGrow += child->computedStyle.flexGrow;
+      FlexItemMeasure measure = child->measureFlexItem(isRow, styleSheet, fontManager);
+      intrinsicSizes.push_back(measure.baseSize);
+      totalFlexGrow += measure.flexGrow;
     }
 
     // For wrapping flex containers, we need to organize children into lines
@@ -2051,7 +2493,7 @@ private:
         }
         
         currentLine.childIndices.push_back(i);
-        currentLine.totalFlexGrow += children[i]->computedStyle.flexGrow;
+        currentLine.totalFlexGrow += children[i]->cachedFlexMeasure.flexGrow;
         lineSize += sizeWithGap;
       }
       
@@ -2103,7 +2545,7 @@ private:
         // Distribute free space based on flex-grow within this line
         float extraSize = 0;
         if (line.totalFlexGrow > 0) {
-          extraSize = (freeSpace * child->computedStyle.flexGrow) / line.totalFlexGrow;
+          extraSize = (freeSpace * child->cachedFlexMeasure.flexGrow) / line.totalFlexGrow;
         }
         
         if (isRow) {
@@ -2138,86 +2580,160 @@ private:
     }
   }
 
-  // Table layout algorithm
-  float layoutTableChildren(float x, float y, float width, StyleSheet &styleSheet,
-                           MSDFFontManager *fontManager, float viewportWidth,
-                           float viewportHeight, float viewportScrollY = 0.0f) {
-    // Find all table rows (including through tbody/thead/tfoot)
-    std::vector<std::shared_ptr<RenderBox>> rows;
-    std::vector<std::vector<std::shared_ptr<RenderBox>>> cellsByRow;
+  // Collect rows, cells and <col> elements of this table (through
+  // tbody/thead/tfoot and colgroup). Cached until the table is dirtied.
+  void collectTableStructure() {
+    if (tableStructureValid) return;
+    
+    tableRows.clear();
+    tableCellsByRow.clear();
+    tableColumns.clear();
+    
+    auto addRow = [this](const std::shared_ptr<RenderBox> &row) {
+      tableRows.push_back(row);
+      std::vector<std::shared_ptr<RenderBox>> cells;
+      for (auto& cellChild : row->children) {
+        if (cellChild->tag == "td" || cellChild->tag == "th") {
+          cells.push_back(cellChild);
+        }
+      }
+      tableCellsByRow.push_back(std::move(cells));
+    };
     
     for (auto& child : children) {
-      auto& childStyle = child->computedStyle;
-      std::string tag = child->node->tagName;
-      std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
-      
-      // Handle tbody, thead, tfoot
+      const std::string &tag = child->tag;
       if (tag == "tbody" || tag == "thead" || tag == "tfoot") {
         for (auto& rowChild : child->children) {
-          auto& rowStyle = rowChild->computedStyle;
-          std::string rowTag = rowChild->node->tagName;
-          std::transform(rowTag.begin(), rowTag.end(), rowTag.begin(), ::tolower);
-          if (rowTag == "tr") {
-            rows.push_back(rowChild);
-            std::vector<std::shared_ptr<RenderBox>> cells;
-            for (auto& cellChild : rowChild->children) {
-              auto& cellStyle = cellChild->computedStyle;
-              std::string cellTag = cellChild->node->tagName;
-              std::transform(cellTag.begin(), cellTag.end(), cellTag.begin(), ::tolower);
-              if (cellTag == "td" || cellTag == "th") {
-                cells.push_back(cellChild);
-              }
-            }
-            cellsByRow.push_back(cells);
-          }
+          if (rowChild->tag == "tr") addRow(rowChild);
         }
-      }
-      // Direct TR children (no tbody)
-      else if (tag == "tr") {
-        rows.push_back(child);
-        std::vector<std::shared_ptr<RenderBox>> cells;
-        for (auto& cellChild : child->children) {
-          auto& cellStyle = cellChild->computedStyle;
-          std::string cellTag = cellChild->node->tagName;
-          std::transform(cellTag.begin(), cellTag.end(), cellTag.begin(), ::tolower);
-          if (cellTag == "td" || cellTag == "th") {
-            cells.push_back(cellChild);
-          }
+      } else if (tag == "tr") {
+        // Direct TR children (no tbody)
+        addRow(child);
+      } else if (tag == "colgroup") {
+        for (auto& colChild : child->children) {
+          if (colChild->tag == "col") tableColumns.push_back(colChild);
         }
-        cellsByRow.push_back(cells);
+      } else if (tag == "col") {
+        tableColumns.push_back(child);
       }
     }
     
-    if (rows.empty()) return 0;
+    tableStructureValid = true;
+  }
+
+  // Drop cached table structure and column widths for this node only
+  void invalidateTableCache() {
+    tableStructureValid = false;
+    columnWidthsValid = false;
+  }
+
+  // table-layout: fixed - column widths come from <col> elements, or from the
+  // cells of the first row, so no cell content is measured and layout is O(rows).
+  // Columns without a specified width share the remaining space equally.
+  std::vector<float> computeFixedColumnWidths(float tableContentWidth, StyleSheet &styleSheet,
+                                              float viewportWidth, float viewportHeight) {
+    // Specified widths per column (-1 = auto)
+    std::vector<float> specified;
+    
+    auto resolveWidth = [&](const std::shared_ptr<RenderBox> &box,
+                            const StyleSheet::ComputedStyle &boxStyle) -> float {
+      CssValue w = boxStyle.width;
+      if (w.isAuto() || w.unit == CssUnit::None) {
+        auto widthAttr = box->node->attributes.find("width");
+        if (widthAttr == box->node->attributes.end()) return -1.0f;
+        w = CssParser::parseValue(widthAttr->second);
+        if (w.isAuto() || w.unit == CssUnit::None) return -1.0f;
+      }
+      return std::max(0.0f, w.toPx(tableContentWidth, boxStyle.fontSize,
+                                   viewportWidth, viewportHeight));
+    };
     
-    // Get table properties
-    float fontSize = computedStyle.fontSize;
-    float parentWidth = width;
-    float paddingLeft = computedStyle.getPaddingLeft(parentWidth, fontSize);
-    float paddingRight = computedStyle.getPaddingRight(parentWidth, fontSize);
-    float borderLeft = computedStyle.getBorderLeftWidth();
-    float borderRight = computedStyle.getBorderRightWidth();
-    float tableContentWidth = width - paddingLeft - paddingRight - borderLeft - borderRight;
+    if (!tableColumns.empty()) {
+      for (auto& col : tableColumns) {
+        StyleSheet::ComputedStyle colStyle = styleSheet.computeStyle(*col->node);
+        float colWidth = resolveWidth(col, colStyle);
+        int span = 1;
+        auto spanAttr = col->node->attributes.find("span");
+        if (spanAttr != col->node->attributes.end()) {
+          try { span = std::max(1, std::stoi(spanAttr->second)); } catch (...) {}
+        }
+        for (int i = 0; i < span; i++) specified.push_back(colWidth);
+      }
+    }
     
-    // Determine number of columns (max cells in any row)
-    size_t numColumns = 0;
-    for (auto& rowCells : cellsByRow) {
-      numColumns = std::max(numColumns, rowCells.size());
+    if (!tableCellsByRow.empty()) {
+      const auto &firstRow = tableCellsByRow[0];
+      for (size_t colIdx = 0; colIdx < firstRow.size(); colIdx++) {
+        auto &cell = firstRow[colIdx];
+        StyleSheet::ComputedStyle cellStyle = styleSheet.computeStyle(*cell->node);
+        float cellWidth = resolveWidth(cell, cellStyle);
+        if (cellWidth >= 0 && cellStyle.boxSizing != BoxSizing::BorderBox) {
+          // Column width is the cell's border box
+          cellWidth += cellStyle.getPaddingLeft(tableContentWidth, cellStyle.fontSize) +
+                       cellStyle.getPaddingRight(tableContentWidth, cellStyle.fontSize) +
+                       cellStyle.getBorderLeftWidth() + cellStyle.getBorderRightWidth();
+        }
+        if (colIdx >= specified.size()) {
+          specified.push_back(cellWidth);
+        } else if (specified[colIdx] < 0) {
+          // <col> widths take precedence over first-row cells
+          specified[colIdx] = cellWidth;
+        }
+      }
     }
     
-    if (numColumns == 0) return 0;
+    float usedWidth = 0;
+    size_t autoColumns = 0;
+    for (float w : specified) {
+      if (w >= 0) {
+        usedWidth += w;
+      } else {
+        autoColumns++;
+      }
+    }
     
-    // FIRST PASS: Measure all cells to determine column widths
-    std::vector<float> columnWidths(numColumns, 0);
-    for (size_t rowIdx = 0; rowIdx < cellsByRow.size(); rowIdx++) {
-      auto& rowCells = cellsByRow[rowIdx];
+    float remaining = std::max(0.0f, tableContentWidth - usedWidth);
+    std::vector<float> columnWidths(specified.size(), 0);
+    for (size_t i = 0; i < specified.size(); i++) {
+      if (specified[i] >= 0) {
+        columnWidths[i] = specified[i];
+        // No auto columns to take the slack: widen specified ones proportionally
+        if (autoColumns == 0 && usedWidth > 0) {
+          columnWidths[i] += remaining * (specified[i] / usedWidth);
+        }
+      } else {
+        columnWidths[i] = remaining / autoColumns;
+      }
+    }
+    return columnWidths;
+  }
+
+  // table-layout: auto - natural column widths from every cell's content.
+  // Cached until a cell is dirtied (or the table width changes, if a cell
+  // uses percentage padding).
+  const std::vector<float> &computeAutoColumnWidths(size_t numColumns, float tableContentWidth,
+                                                    MSDFFontManager *fontManager) {
+    if (columnWidthsValid && cachedColumnWidths.size() == numColumns &&
+        (!columnWidthsDependOnWidth || columnWidthsBasis == LayoutUnit::fromPx(tableContentWidth))) {
+      return cachedColumnWidths;
+    }
+    
+    // Only cached once every cell has resolved its own style
+    bool cacheable = true;
+    bool dependsOnWidth = false;
+    cachedColumnWidths.assign(numColumns, 0);
+    for (size_t rowIdx = 0; rowIdx < tableCellsByRow.size(); rowIdx++) {
+      auto& rowCells = tableCellsByRow[rowIdx];
       for (size_t colIdx = 0; colIdx < rowCells.size(); colIdx++) {
-        auto cell = rowCells[colIdx];
+        auto& cell = rowCells[colIdx];
         auto& cellStyle = cell->computedStyle;
+        if (!cell->styleResolved) cacheable = false;
+        if (cellStyle.padding.left.unit == CssUnit::Percent ||
+            cellStyle.padding.right.unit == CssUnit::Percent) {
+          dependsOnWidth = true;
+        }
         float cellFontSize = cellStyle.fontSize;
-        MSDFFont* cellFont = fontManager->getFont(cellStyle.fontFamily,
-            static_cast<int>(cellStyle.fontWeight), static_cast<int>(cellStyle.fontStyle));
-        if (!cellFont) cellFont = fontManager->getDefaultFont();
+        MSDFFont* cellFont = fontForStyle(fontManager, cellStyle);
         
         // Get cell padding and border
         float cellPaddingLeft = cellStyle.getPaddingLeft(tableContentWidth, cellFontSize);
@@ -2229,36 +2745,90 @@ private:
         // Measure just the text content (tightly)
         float cellContentWidth = 0;
         if (cell->node->type == NodeType::Text && cellFont) {
-          cellContentWidth = cellFont->getTextWidth(cell->node->textContent, cellFontSize);
+          cellContentWidth = cell->measureIntrinsicWidth(cellFont, cellFontSize);
         } else {
           // For non-text cells, measure text children
           for (auto& child : cell->children) {
             if (child->node->type == NodeType::Text && cellFont) {
-              cellContentWidth += cellFont->getTextWidth(child->node->textContent, cellFontSize);
+              cellContentWidth += child->measureIntrinsicWidth(cellFont, cellFontSize);
             }
           }
         }
         
         float cellTotalWidth = cellContentWidth + cellHorizontalSpace;
-        columnWidths[colIdx] = std::max(columnWidths[colIdx], cellTotalWidth);
+        cachedColumnWidths[colIdx] = std::max(cachedColumnWidths[colIdx], cellTotalWidth);
       }
     }
     
-    // Distribute column widths: sum up and scale if needed
-    float totalColumnWidth = 0;
-    for (float w : columnWidths) {
-      totalColumnWidth += w;
-    }
+    columnWidthsValid = cacheable;
+    columnWidthsDependOnWidth = dependsOnWidth;
+    columnWidthsBasis = LayoutUnit::fromPx(tableContentWidth);
+    return cachedColumnWidths;
+  }
+
+  // Table layout algorithm
+  float layoutTableChildren(float x, float y, float width, StyleSheet &styleSheet,
+                           MSDFFontManager *fontManager, float viewportWidth,
+                           float viewportHeight, float viewportScrollY = 0.0f) {
+    // Find all table rows (including through tbody/thead/tfoot)
+    collectTableStructure();
+    const auto &rows = tableRows;
+    const auto &cellsByRow = tableCellsByRow;
+    
+    if (rows.empty()) return 0;
     
-    // If columns exceed available width, scale them proportionally
-    if (totalColumnWidth > tableContentWidth) {
-      float scale = tableContentWidth / totalColumnWidth;
-      for (float& w : columnWidths) {
-        w *= scale;
+    // Get table properties
+    float fontSize = computedStyle.fontSize;
+    float parentWidth = width;
+    float paddingLeft = computedStyle.getPaddingLeft(parentWidth, fontSize);
+    float paddingRight = computedStyle.getPaddingRight(parentWidth, fontSize);
+    float borderLeft = computedStyle.getBorderLeftWidth();
+    float borderRight = computedStyle.getBorderRightWidth();
+    float tableContentWidth = width - paddingLeft - paddingRight - borderLeft - borderRight;
+    
+    // Fixed layout only applies when the table itself has a width (CSS 2.1 17.5.2.1)
+    bool fixedLayout = computedStyle.tableLayout == TableLayout::Fixed &&
+                       !computedStyle.width.isAuto();
+    
+    std::vector<float> columnWidths;
+    if (fixedLayout) {
+      columnWidths = computeFixedColumnWidths(tableContentWidth, styleSheet,
+                                              viewportWidth, viewportHeight);
+    } else {
+      // Determine number of columns (max cells in any row)
+      size_t numColumns = 0;
+      for (auto& rowCells : cellsByRow) {
+        numColumns = std::max(numColumns, rowCells.size());
+      }
+      
+      if (numColumns == 0) return 0;
+      
+      // FIRST PASS: Measure all cells to determine column widths
+      columnWidths = computeAutoColumnWidths(numColumns, tableContentWidth, fontManager);
+      
+      // Distribute column widths: sum up and scale if needed
+      float totalColumnWidth = 0;
+      for (float w : columnWidths) {
+        totalColumnWidth += w;
+      }
+      
+      // If columns exceed available width, scale them proportionally
+      if (totalColumnWidth > tableContentWidth) {
+        float scale = tableContentWidth / totalColumnWidth;
+        for (float& w : columnWidths) {
+          w *= scale;
+        }
       }
     }
     
+    if (columnWidths.empty()) return 0;
+    
     // SECOND PASS: Layout rows and cells with calculated column widths
+    // (in fixed layout, cells beyond the first row's columns get no width)
+    auto columnWidth = [&columnWidths](size_t colIdx) {
+      return colIdx < columnWidths.size() ? columnWidths[colIdx] : 0.0f;
+    };
+    
     float currentY = y;
     for (size_t rowIdx = 0; rowIdx < rows.size(); rowIdx++) {
       auto row = rows[rowIdx];
@@ -2268,12 +2838,14 @@ private:
       float maxRowHeight = 0;
       
       // First, layout all cells in this row with their column widths
+      row->subtreeHasPaintLayer = false;
       for (size_t colIdx = 0; colIdx < rowCells.size(); colIdx++) {
         auto cell = rowCells[colIdx];
-        float cellWidth = columnWidths[colIdx];
+        float cellWidth = columnWidth(colIdx);
         
         // Layout cell with its column width
         cell->layout(currentX, currentY, cellWidth, styleSheet, fontManager, viewportWidth, viewportHeight, false, viewportScrollY);
+        if (cell->subtreeHasPaintLayer) row->subtreeHasPaintLayer = true;
         
         maxRowHeight = std::max(maxRowHeight, cell->frame.height);
         currentX += cellWidth;
@@ -2288,9 +2860,10 @@ private:
         auto cell = rowCells[colIdx];
         cell->frame.x = currentX;
         cell->frame.y = currentY;
-        cell->frame.width = columnWidths[colIdx];
-        currentX += columnWidths[colIdx];
+        cell->frame.width = columnWidth(colIdx);
+        currentX += columnWidth(colIdx);
       }
+      row->updateOverflow();
       
       currentY += maxRowHeight;
     }
@@ -2300,17 +2873,18 @@ private:
     
     // Also layout any tbody/thead/tfoot groups (update their frames)
     for (auto& child : children) {
-      auto& childStyle = child->computedStyle;
-      std::string tag = child->node->tagName;
-      std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
+      const std::string &tag = child->tag;
       if (tag == "tbody" || tag == "thead" || tag == "tfoot") {
         float groupStartY = y;
         float groupHeight = 0;
         // Calculate group height based on its rows
+        child->subtreeHasPaintLayer = false;
         for (auto& rowChild : child->children) {
           groupHeight += rowChild->frame.height;
+          if (rowChild->subtreeHasPaintLayer) child->subtreeHasPaintLayer = true;
         }
         child->frame = {x, groupStartY, columnWidths.empty() ? 0 : (x + columnWidths[0] + (columnWidths.size() > 1 ? columnWidths[1] : 0)), groupHeight};
+        child->updateOverflow();
         groupStartY += groupHeight;
       }
     }
@@ -2336,41 +2910,1123 @@ public:
   std::shared_ptr<RenderBox> getptr() { return shared_from_this(); }
 };
 
+inline void TextSelection::setTextBoxes(std::vector<std::shared_ptr<RenderBox>> boxes,
+                                        uint64_t generation) {
+  allTextBoxes = std::move(boxes);
+  for (size_t i = 0; i < allTextBoxes.size(); ++i) {
+    allTextBoxes[i]->textBoxIndex = static_cast<int>(i);
+  }
+  textBoxGeneration = generation;
+}
+
+inline void TextSelection::replaceTextBoxes(uint32_t treeOrder, uint32_t treeOrderEnd,
+                                            std::vector<std::shared_ptr<RenderBox>> boxes) {
+  auto byOrder = [](const std::shared_ptr<RenderBox> &box, uint32_t order) {
+    return box->treeOrder < order;
+  };
+  auto first = std::lower_bound(allTextBoxes.begin(), allTextBoxes.end(), treeOrder, byOrder);
+  auto last = std::lower_bound(first, allTextBoxes.end(), treeOrderEnd, byOrder);
+  size_t start = first - allTextBoxes.begin();
+  size_t removed = last - first;
+  size_t renumberEnd = start + boxes.size();
+  if (boxes.size() == removed) {
+    std::move(boxes.begin(), boxes.end(), first);
+  } else {
+    allTextBoxes.erase(first, last);
+    allTextBoxes.insert(allTextBoxes.begin() + start, std::make_move_iterator(boxes.begin()),
+                        std::make_move_iterator(boxes.end()));
+    renumberEnd = allTextBoxes.size();
+  }
+  for (size_t i = start; i < renumberEnd; ++i) allTextBoxes[i]->textBoxIndex = static_cast<int>(i);
+}
+
+inline int TextSelection::getBoxIndex(const std::shared_ptr<RenderBox> &box) const {
+  if (!box) return -1;
+  int index = box->textBoxIndex;
+  if (index < 0 || index >= static_cast<int>(allTextBoxes.size()) ||
+      allTextBoxes[index].get() != box.get()) {
+    return -1;
+  }
+  return index;
+}
+
+// Bump allocator backing the render boxes of one tree. build() allocates in
+// tree order, so a subtree's boxes sit next to each other in memory instead of
+// wherever the general heap put them. Nothing is freed on its own: the blocks
+// go away with the arena, which every box keeps alive through the
+// ArenaAllocator copy in its control block.
+class RenderArena {
+public:
+  static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+  size_t bytesReserved = 0;
+  size_t bytesAllocated = 0;
+
+  void *allocate(size_t bytes, size_t alignment) {
+    if (!blocks.empty()) {
+      void *ptr = blocks.back().get() + blockUsed;
+      size_t space = blockCapacity - blockUsed;
+      if (std::align(alignment, bytes, ptr, space)) {
+        blockUsed = blockCapacity - space + bytes;
+        bytesAllocated += bytes;
+        return ptr;
+      }
+    }
+
+    blockCapacity = std::max(BLOCK_SIZE, bytes + alignment);
+    blocks.push_back(std::make_unique<std::byte[]>(blockCapacity));
+    bytesReserved += blockCapacity;
+    void *ptr = blocks.back().get();
+    size_t space = blockCapacity;
+    std::align(alignment, bytes, ptr, space);
+    blockUsed = blockCapacity - space + bytes;
+    bytesAllocated += bytes;
+    return ptr;
+  }
+
+private:
+  std::vector<std::unique_ptr<std::byte[]>> blocks;
+  size_t blockCapacity = 0;
+  size_t blockUsed = 0;
+};
+
+template <typename T> struct ArenaAllocator {
+  using value_type = T;
+
+  std::shared_ptr<RenderArena> arena;
+
+  explicit ArenaAllocator(std::shared_ptr<RenderArena> arena) : arena(std::move(arena)) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(size_t n) {
+    return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, size_t) {}
+
+  template <typename U> bool operator==(const ArenaAllocator<U> &other) const {
+    return arena == other.arena;
+  }
+};
+
+// Border boxes of the laid-out tree in tree (pre-)order, one array per edge, so
+// hit-testing and culling scan flat memory instead of chasing child pointers.
+// subtreeEnd[i] is one past box i's last descendant - jumping there skips the
+// subtree. Children of skipped or deferred content aren't listed.
+//
+// On top of that, a spatial index for point and text-line queries: border
+// boxes and text lines bucketed into horizontal bands (a uniform grid one cell
+// wide - pages are long, not wide). Every scroll container opens a scope with
+// its own bands, indexed in unscrolled layout coordinates, and so does every
+// paint layer, whose subtree is painted translated (scrolled with an ancestor,
+// or moved by fixed or sticky positioning). place() records where each scope
+// is this frame and queries shift the point by that, so scrolling never
+// invalidates the index. It also buckets the scopes' page bounds into bands of
+// their own, so a query only looks into the scopes around its point.
+struct BoxGeometryTable {
+  static constexpr uint32_t NONE = UINT32_MAX;
+  static constexpr float BAND_HEIGHT = 128.0f;
+  static constexpr size_t MAX_BANDS = 1 << 16;
+
+  struct TextLineRef {
+    uint32_t box;
+    uint32_t line;
+  };
+
+  struct ScrollScope {
+    uint32_t container = NONE;  // Scroll container box, NONE for the page or a layer
+    uint32_t parentScope = NONE;
+    uint32_t layer = NONE;      // Paint layer box the scope is in, NONE in the normal flow
+    float bandTop = 0.0f;
+    float bandHeight = BAND_HEIGHT;
+    Rect extent;  // Around its boxes and text lines, empty if it has no bands
+    std::vector<std::vector<uint32_t>> boxBands;  // Box indices, ascending
+    std::vector<std::vector<TextLineRef>> lineBands;
+    std::vector<std::pair<float, TextLineRef>> linesByMidY;
+
+    int bandOf(float y) const {
+      return (int)std::floor((y - bandTop) / bandHeight);
+    }
+    int bandCount() const { return (int)boxBands.size(); }
+  };
+
+  // Where a scope is this frame: the offset from page to its layout
+  // coordinates, whether it's painted at all, and the clip of the paint layer
+  // it's in (page coordinates). order is that layer's place in paint order,
+  // the normal flow being 0 and layers beneath it negative. firstBand and
+  // lastBand are the page bands its extent is listed in (none if it's empty
+  // or not painted).
+  struct Placement {
+    float offsetX = 0.0f, offsetY = 0.0f;
+    bool visible = true;
+    bool clipped = false;
+    Rect clip;
+    int order = 0;
+    int firstBand = 0, lastBand = -1;
+  };
+
+  // A text line found by a query; localX/localY is the query point in the
+  // line's own (unscrolled) coordinates
+  struct TextLineHit {
+    RenderBox *box = nullptr;
+    size_t lineIndex = 0;
+    float localX = 0.0f, localY = 0.0f;
+  };
+
+  std::vector<float> left, top, right, bottom;
+  std::vector<uint32_t> subtreeEnd;
+  std::vector<uint32_t> parent;
+  std::vector<uint32_t> scope;  // Scope the box's geometry is in
+  std::vector<RenderBox *> boxes;
+  std::vector<ScrollScope> scopes;
+  std::vector<Placement> placements;  // By scope, see place()
+  // Page bands of place(): scope indices but the page's own, ascending
+  float pageBandTop = 0.0f;
+  float pageBandHeight = BAND_HEIGHT;
+  std::vector<std::vector<uint32_t>> pageBands;
+  size_t pageScopeCount = 0;  // Scopes listed in them
+
+  size_t size() const { return boxes.size(); }
+
+  void rebuild(RenderBox *root, size_t capacity) {
+    for (auto *edges : {&left, &top, &right, &bottom}) {
+      edges->clear();
+      edges->reserve(capacity);
+    }
+    for (auto *indices : {&subtreeEnd, &parent, &scope}) {
+      indices->clear();
+      indices->reserve(capacity);
+    }
+    boxes.clear();
+    boxes.reserve(capacity);
+    scopes.clear();
+    scopes.emplace_back();
+    if (root) append(root, NONE, 0);
+    buildBands();
+    placements.assign(scopes.size(), {});
+    pageBands.clear();
+  }
+
+  // Place every scope for this frame. layerOf(box) gives the paint layer a
+  // layer box is drawn as (offsetX/offsetY from layout to page coordinates,
+  // clip, clipped, order), or null if it isn't drawn. Scroll containers are
+  // read as they are now; parents come before children.
+  template <typename LayerOf>
+  void place(LayerOf &&layerOf) {
+    placements.assign(scopes.size(), {});
+    for (size_t s = 1; s < scopes.size(); ++s) {
+      const auto &sc = scopes[s];
+      auto &placement = placements[s];
+      if (sc.container == NONE) {
+        if (const auto *layer = layerOf(boxes[sc.layer])) {
+          placement = {-layer->offsetX, -layer->offsetY, true, layer->clipped, layer->clip,
+                       layer->order};
+        } else {
+          placement.visible = false;
+        }
+      } else {
+        const RenderBox *container = boxes[sc.container];
+        placement = placements[sc.parentScope];
+        placement.offsetX += container->scrollX;
+        placement.offsetY += container->scrollY;
+      }
+    }
+
+    // Page rows each painted scope's extent covers, a pixel wider either way
+    // so rounding the offset can't leave a point out. Points are checked
+    // against the extent itself in the scope's coordinates. The page's own
+    // scope covers the page and isn't listed: queries always look into it.
+    auto pageRows = [&](uint32_t s) {
+      const Rect &extent = scopes[s].extent;
+      return std::pair<float, float>{extent.y - placements[s].offsetY - 1.0f,
+                                     extent.bottom() - placements[s].offsetY + 1.0f};
+    };
+    float minY = std::numeric_limits<float>::max(), maxY = std::numeric_limits<float>::lowest();
+    for (uint32_t s = 1; s < scopes.size(); ++s) {
+      if (scopes[s].bandCount() == 0 || !placements[s].visible) continue;
+      auto [y0, y1] = pageRows(s);
+      minY = std::min(minY, y0);
+      maxY = std::max(maxY, y1);
+    }
+    for (auto &band : pageBands) band.clear();
+    pageScopeCount = 0;
+    if (minY > maxY) {
+      pageBands.clear();
+      return;
+    }
+    pageBandTop = minY;
+    pageBandHeight = std::max(BAND_HEIGHT, (maxY - minY) / (float)MAX_BANDS);
+    pageBands.resize((size_t)pageBandOf(maxY) + 1);
+    int count = (int)pageBands.size();
+    for (uint32_t s = 1; s < scopes.size(); ++s) {
+      if (scopes[s].bandCount() == 0 || !placements[s].visible) continue;
+      auto [y0, y1] = pageRows(s);
+      auto &placement = placements[s];
+      placement.firstBand = std::clamp(pageBandOf(y0), 0, count - 1);
+      placement.lastBand = std::clamp(pageBandOf(y1), placement.firstBand, count - 1);
+      for (int band = placement.firstBand; band <= placement.lastBand; ++band) {
+        pageBands[band].push_back(s);
+      }
+      ++pageScopeCount;
+    }
+  }
+
+  // Deepest box whose border box contains the point, with every ancestor up
+  // to its paint layer's box containing it too. The topmost paint layer with
+  // such a box wins (the normal flow counting as one), then the last such box
+  // in tree order - which is what walking children last to first finds. NONE
+  // if there is none.
+  uint32_t boxAt(float x, float y) const {
+    uint32_t best = NONE;
+    int bestOrder = std::numeric_limits<int>::min();
+    forEachScopeAt(y, [&](uint32_t s) {
+      const auto &sc = scopes[s];
+      const auto &placement = placements[s];
+      if (placement.order < bestOrder || !reaches(s, x, y)) return;
+      bool sameLayer = best != NONE && placement.order == bestOrder;
+      // Everything in a scope lies inside its container's or layer's subtree
+      uint32_t owner = sc.container != NONE ? sc.container : sc.layer;
+      if (sameLayer && owner != NONE && subtreeEnd[owner] - 1 <= best) return;
+      float px = x + placement.offsetX, py = y + placement.offsetY;
+      if (!contains(sc.extent, px, py)) return;
+      const auto &entries = sc.boxBands[sc.bandOf(py)];
+      for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        uint32_t i = *it;
+        if (sameLayer && i <= best) break;
+        if (contains(i, px, py) && ancestorsContain(i, x, y)) {
+          best = i;
+          bestOrder = placement.order;
+          break;
+        }
+      }
+    });
+    return best;
+  }
+
+  // Text line containing the point; the topmost paint layer wins, then the
+  // last text box in tree order, then its first such line
+  TextLineHit textLineAt(float x, float y) const {
+    TextLineHit hit;
+    uint32_t bestBox = NONE, bestLine = 0;
+    int bestOrder = std::numeric_limits<int>::min();
+    forEachScopeAt(y, [&](uint32_t s) {
+      const auto &sc = scopes[s];
+      const auto &placement = placements[s];
+      if (placement.order < bestOrder || !reaches(s, x, y)) return;
+      float px = x + placement.offsetX, py = y + placement.offsetY;
+      if (!contains(sc.extent, px, py)) return;
+      for (const auto &ref : sc.lineBands[sc.bandOf(py)]) {
+        if (bestBox != NONE && placement.order == bestOrder &&
+            (ref.box < bestBox || (ref.box == bestBox && ref.line > bestLine))) {
+          continue;
+        }
+        const auto &line = boxes[ref.box]->textLines[ref.line];
+        if (py >= line.y && py < line.y + line.height && px >= line.x && px < line.x + line.width) {
+          bestOrder = placement.order;
+          bestBox = ref.box;
+          bestLine = ref.line;
+          hit = {boxes[ref.box], ref.line, px, py};
+        }
+      }
+    });
+    return hit;
+  }
+
+  // Every text line whose vertical extent contains y, in tree order
+  std::vector<TextLineHit> textLinesAtY(float x, float y) const {
+    std::vector<std::pair<TextLineRef, TextLineHit>> found;
+    forEachScopeAt(y, [&](uint32_t s) {
+      const auto &sc = scopes[s];
+      float px = x + placements[s].offsetX, py = y + placements[s].offsetY;
+      if (py < sc.extent.y || py >= sc.extent.bottom()) return;
+      for (const auto &ref : sc.lineBands[sc.bandOf(py)]) {
+        const auto &line = boxes[ref.box]->textLines[ref.line];
+        if (py >= line.y && py < line.y + line.height) {
+          found.push_back({ref, {boxes[ref.box], ref.line, px, py}});
+        }
+      }
+    });
+    std::sort(found.begin(), found.end(), [](const auto &a, const auto &b) {
+      return precedes(a.first, b.first);
+    });
+    std::vector<TextLineHit> hits;
+    for (auto &entry : found) hits.push_back(entry.second);
+    return hits;
+  }
+
+  // Text line whose vertical middle is nearest to y; ties go to the first in
+  // tree order
+  TextLineHit textLineNearestY(float x, float y) const {
+    TextLineHit hit;
+    TextLineRef bestRef{NONE, 0};
+    float bestDist = std::numeric_limits<float>::max();
+    auto within = [&](float gap) { return gap <= bestDist; };
+    forEachScopeOutward(y, within, [&](uint32_t s) {
+      const auto &lines = scopes[s].linesByMidY;
+      if (lines.empty()) return;
+      float px = x + placements[s].offsetX, py = y + placements[s].offsetY;
+      auto consider = [&](const std::pair<float, TextLineRef> &entry) {
+        float dist = std::abs(py - entry.first);
+        if (dist < bestDist || (dist == bestDist && precedes(entry.second, bestRef))) {
+          bestDist = dist;
+          bestRef = entry.second;
+          hit = {boxes[entry.second.box], entry.second.line, px, py};
+        }
+      };
+      // Nearest middles are around py; equal ones sit next to each other
+      auto it = std::lower_bound(lines.begin(), lines.end(), py,
+                                 [](const auto &entry, float value) { return entry.first < value; });
+      for (auto below = it; below != lines.begin();) {
+        --below;
+        if (std::abs(py - below->first) > bestDist) break;
+        consider(*below);
+      }
+      for (auto above = it; above != lines.end(); ++above) {
+        if (std::abs(py - above->first) > bestDist) break;
+        consider(*above);
+      }
+    });
+    return hit;
+  }
+
+  // Text line nearest to the point (squared distance to its rect); ties go to
+  // the first in tree order. Searches bands outward from the point's band.
+  TextLineHit nearestTextLine(float x, float y) const {
+    TextLineHit hit;
+    TextLineRef bestRef{NONE, 0};
+    float bestDist = std::numeric_limits<float>::max();
+    auto within = [&](float gap) { return gap * gap <= bestDist; };
+    forEachScopeOutward(y, within, [&](uint32_t s) {
+      const auto &sc = scopes[s];
+      if (sc.linesByMidY.empty()) return;
+      int count = sc.bandCount();
+      float px = x + placements[s].offsetX, py = y + placements[s].offsetY;
+      int start = std::clamp(sc.bandOf(py), 0, count - 1);
+      auto bandGap = [&](int band) {
+        float bandTop = sc.bandTop + band * sc.bandHeight;
+        float bandBottom = bandTop + sc.bandHeight;
+        return py < bandTop ? bandTop - py : (py > bandBottom ? py - bandBottom : 0.0f);
+      };
+      auto scan = [&](int band) {
+        for (const auto &ref : sc.lineBands[band]) {
+          const auto &line = boxes[ref.box]->textLines[ref.line];
+          float dy = py < line.y ? line.y - py : (py > line.y + line.height ? py - (line.y + line.height) : 0.0f);
+          float dx = px < line.x ? line.x - px : (px > line.x + line.width ? px - (line.x + line.width) : 0.0f);
+          float dist = dx * dx + dy * dy;
+          if (dist < bestDist || (dist == bestDist && precedes(ref, bestRef))) {
+            bestDist = dist;
+            bestRef = ref;
+            hit = {boxes[ref.box], ref.line, px, py};
+          }
+        }
+      };
+      // Bands only get farther from the point in both directions
+      for (int step = 0;; ++step) {
+        int up = start - step, down = start + step;
+        if (up < 0 && down >= count) break;
+        float gap = std::min(up >= 0 ? bandGap(up) : std::numeric_limits<float>::max(),
+                             down < count ? bandGap(down) : std::numeric_limits<float>::max());
+        if (gap * gap > bestDist) break;
+        if (up >= 0) scan(up);
+        if (down < count && down != up) scan(down);
+      }
+    });
+    return hit;
+  }
+
+  // Visit the text lines overlapping page rows [y0, y1], each once, as
+  // fn(box, lineIndex, offsetX, offsetY); the offset takes the line from its
+  // own coordinates to the page's (scroll containers scrolled, paint layers
+  // moved)
+  template <typename Fn>
+  void forEachTextLineIn(float y0, float y1, Fn &&fn) const {
+    std::vector<uint32_t> inRange{0};
+    int count = (int)pageBands.size();
+    int firstPage = std::max(pageBandOf(y0), 0);
+    int lastPage = std::min(pageBandOf(y1), count - 1);
+    for (int band = firstPage; band <= lastPage; ++band) {
+      for (uint32_t s : pageBands[band]) {
+        // Scopes spanning bands are listed in each
+        if (std::max(placements[s].firstBand, firstPage) == band) inRange.push_back(s);
+      }
+    }
+    std::sort(inRange.begin(), inRange.end());
+    for (uint32_t s : inRange) {
+      const auto &sc = scopes[s];
+      if (sc.bandCount() == 0) continue;
+      float offsetX = placements[s].offsetX, offsetY = placements[s].offsetY;
+      float top = y0 + offsetY, bottom = y1 + offsetY;
+      int first = std::max(sc.bandOf(top), 0);
+      int last = std::min(sc.bandOf(bottom), sc.bandCount() - 1);
+      for (int band = first; band <= last; ++band) {
+        for (const auto &ref : sc.lineBands[band]) {
+          const auto &line = boxes[ref.box]->textLines[ref.line];
+          if (line.y + line.height < top || line.y > bottom) continue;
+          // Lines spanning bands are listed in each
+          if (std::max(sc.bandOf(line.y), first) != band) continue;
+          fn(boxes[ref.box], (size_t)ref.line, -offsetX, -offsetY);
+        }
+      }
+    }
+  }
+
+private:
+  static bool precedes(const TextLineRef &a, const TextLineRef &b) {
+    return a.box < b.box || (a.box == b.box && a.line < b.line);
+  }
+
+  bool contains(uint32_t i, float x, float y) const {
+    return x >= left[i] && x < right[i] && y >= top[i] && y < bottom[i];
+  }
+
+  static bool contains(const Rect &r, float x, float y) {
+    return x >= r.x && x < r.right() && y >= r.y && y < r.bottom();
+  }
+
+  int pageBandOf(float y) const {
+    return (int)std::floor((y - pageBandTop) / pageBandHeight);
+  }
+
+  // Visit the painted scopes that can hold row y (page coordinates) as
+  // fn(scope): the page's own, then those listed in y's page band
+  template <typename Fn>
+  void forEachScopeAt(float y, Fn &&fn) const {
+    if (scopes.empty()) return;
+    fn(0u);
+    if (pageBands.empty()) return;
+    int band = pageBandOf(y);
+    if (band < 0 || band >= (int)pageBands.size()) return;
+    for (uint32_t s : pageBands[band]) fn(s);
+  }
+
+  // Visit the painted scopes as fn(scope), each once: the page's own, then
+  // page bands outward from row y while within(gap) says something gap rows
+  // away can still count
+  template <typename Within, typename Fn>
+  void forEachScopeOutward(float y, Within &&within, Fn &&fn) const {
+    if (scopes.empty()) return;
+    if (scopes[0].bandCount() > 0) fn(0u);
+    int count = (int)pageBands.size();
+    if (count == 0) return;
+    int start = std::clamp(pageBandOf(y), 0, count - 1);
+    auto bandGap = [&](int band) {
+      float bandTop = pageBandTop + band * pageBandHeight;
+      float bandBottom = bandTop + pageBandHeight;
+      return y < bandTop ? bandTop - y : (y > bandBottom ? y - bandBottom : 0.0f);
+    };
+    // A scope is visited in its first band the sweep reaches
+    size_t visited = 0;
+    auto visit = [&](int band) {
+      for (uint32_t s : pageBands[band]) {
+        if (std::clamp(start, placements[s].firstBand, placements[s].lastBand) != band) continue;
+        fn(s);
+        ++visited;
+      }
+    };
+    for (int step = 0; visited < pageScopeCount; ++step) {
+      int up = start - step, down = start + step;
+      if (up < 0 && down >= count) break;
+      float gap = std::min(up >= 0 ? bandGap(up) : std::numeric_limits<float>::max(),
+                           down < count ? bandGap(down) : std::numeric_limits<float>::max());
+      if (!within(gap)) break;
+      if (up >= 0) visit(up);
+      if (down < count && down != up) visit(down);
+    }
+  }
+
+  // True if the point (page coordinates) can hit scope s: it's painted, and
+  // inside its layer's clip
+  bool reaches(uint32_t s, float x, float y) const {
+    const auto &placement = placements[s];
+    if (!placement.visible) return false;
+    const Rect &clip = placement.clip;
+    return !placement.clipped || (x >= clip.x && x < clip.right() && y >= clip.y && y < clip.bottom());
+  }
+
+  // True if box i's ancestors up to its paint layer's box contain the point
+  // (page coordinates); the layer's own box is as far as its clip goes
+  bool ancestorsContain(uint32_t i, float x, float y) const {
+    for (uint32_t a = i; parent[a] != NONE && scopes[scope[a]].layer != a;) {
+      a = parent[a];
+      const auto &placement = placements[scope[a]];
+      if (!contains(a, x + placement.offsetX, y + placement.offsetY)) return false;
+    }
+    return true;
+  }
+
+  void append(RenderBox *box, uint32_t parentIndex, uint32_t scopeIndex) {
+    Rect borderBox = box->box.borderBox();
+    uint32_t index = (uint32_t)boxes.size();
+    if (parentIndex != NONE && box->isPaintLayer()) {
+      scopeIndex = (uint32_t)scopes.size();
+      scopes.emplace_back();
+      scopes.back().layer = index;
+    }
+    left.push_back(borderBox.x);
+    top.push_back(borderBox.y);
+    right.push_back(borderBox.x + borderBox.width);
+    bottom.push_back(borderBox.y + borderBox.height);
+    subtreeEnd.push_back(index + 1);
+    parent.push_back(parentIndex);
+    scope.push_back(scopeIndex);
+    boxes.push_back(box);
+    if (box->childrenLaidOut() && !box->children.empty()) {
+      uint32_t childScope = scopeIndex;
+      auto overflow = box->computedStyle.overflow;
+      if (overflow == Overflow::Scroll || overflow == Overflow::Auto) {
+        childScope = (uint32_t)scopes.size();
+        scopes.emplace_back();
+        scopes.back().container = index;
+        scopes.back().parentScope = scopeIndex;
+        scopes.back().layer = scopes[scopeIndex].layer;
+      }
+      for (auto &child : box->children) append(child.get(), index, childScope);
+    }
+    subtreeEnd[index] = (uint32_t)boxes.size();
+  }
+
+  void buildBands() {
+    // Extent of each scope: left, top, right, bottom
+    constexpr float MAX = std::numeric_limits<float>::max();
+    std::vector<std::array<float, 4>> extents(scopes.size(), {MAX, MAX, -MAX, -MAX});
+    auto extend = [&](uint32_t s, float x0, float y0, float x1, float y1) {
+      auto &e = extents[s];
+      e = {std::min(e[0], x0), std::min(e[1], y0), std::max(e[2], x1), std::max(e[3], y1)};
+    };
+    for (uint32_t i = 0; i < boxes.size(); ++i) {
+      extend(scope[i], left[i], top[i], right[i], bottom[i]);
+      for (const auto &line : boxes[i]->textLines) {
+        extend(scope[i], line.x, line.y, line.x + line.width, line.y + line.height);
+      }
+    }
+    for (uint32_t s = 0; s < scopes.size(); ++s) {
+      auto &sc = scopes[s];
+      auto [minX, minY, maxX, maxY] = extents[s];
+      if (minY > maxY) continue;
+      sc.extent = {minX, minY, maxX - minX, maxY - minY};
+      sc.bandTop = minY;
+      sc.bandHeight = std::max(BAND_HEIGHT, (maxY - minY) / (float)MAX_BANDS);
+      size_t count = (size_t)sc.bandOf(maxY) + 1;
+      sc.boxBands.assign(count, {});
+      sc.lineBands.assign(count, {});
+    }
+
+    auto bandRange = [](const ScrollScope &sc, float y0, float y1) {
+      int first = std::clamp(sc.bandOf(y0), 0, sc.bandCount() - 1);
+      int last = std::clamp(sc.bandOf(y1), first, sc.bandCount() - 1);
+      return std::pair<int, int>{first, last};
+    };
+    for (uint32_t i = 0; i < boxes.size(); ++i) {
+      auto &sc = scopes[scope[i]];
+      // Empty boxes can't contain a point
+      if (right[i] > left[i] && bottom[i] > top[i]) {
+        auto [first, last] = bandRange(sc, top[i], bottom[i]);
+        for (int band = first; band <= last; ++band) sc.boxBands[band].push_back(i);
+      }
+      const auto &lines = boxes[i]->textLines;
+      if (boxes[i]->node->type != NodeType::Text) continue;
+      for (uint32_t l = 0; l < lines.size(); ++l) {
+        TextLineRef ref{i, l};
+        auto [first, last] = bandRange(sc, lines[l].y, lines[l].y + lines[l].height);
+        for (int band = first; band <= last; ++band) sc.lineBands[band].push_back(ref);
+        sc.linesByMidY.push_back({lines[l].y + lines[l].height / 2.0f, ref});
+      }
+    }
+    for (auto &sc : scopes) {
+      std::sort(sc.linesByMidY.begin(), sc.linesByMidY.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first || (a.first == b.first && precedes(a.second, b.second));
+      });
+    }
+  }
+};
+
 class RenderTree {
 public:
   std::shared_ptr<RenderBox> root;
+  // Storage for root and its descendants; replaced on every build
+  std::shared_ptr<RenderArena> arena;
+  size_t boxCount = 0;
+  // Moves on whenever the laid-out text boxes (the ones with lines, outside
+  // skipped or deferred subtrees) may have changed, so selection's text box list
+  // is only collected again when it has to be. Unique across trees.
+  uint64_t textBoxGeneration = 0;
   float viewportWidth = 1024.0f;
   float viewportHeight = 768.0f;
+  // Polled by build and by every box a pass lays out; once set, they stop
+  // within a box and leave the tree unfinished (LayoutWorker::cancel)
+  const std::atomic<bool> *abortFlag = nullptr;
+
+  // Relayout roots (dirty boundaries, or the root) collected by markNeedsLayout
+  // since the last pass
+  std::vector<std::weak_ptr<RenderBox>> dirtyRelayoutRoots;
 
   std::shared_ptr<RenderBox> build(std::shared_ptr<Node> node) {
-    auto box = std::make_shared<RenderBox>(node);
+    if (!arena) arena = std::make_shared<RenderArena>();
+    auto box = std::allocate_shared<RenderBox>(ArenaAllocator<RenderBox>(arena), node);
+    box->treeOrder = (uint32_t)boxCount++;
 
     for (auto &child : node->children) {
+      if (abortFlag && abortFlag->load(std::memory_order_relaxed)) break;
       box->addChild(build(child));
     }
+    box->treeOrderEnd = (uint32_t)boxCount;
     return box;
   }
 
+  // content-visibility:auto subtrees outside the viewport laid out per pass
+  static constexpr int LAZY_LAYOUT_BUDGET = 4;
+  // Text box changes logged before selection has to collect its list afresh
+  static constexpr size_t MAX_TEXT_BOX_CHANGES = 1024;
+
+  // The subtrees whose text boxes changed since generation since, oldest
+  // first. False if they aren't known - another tree's generation, or too many
+  // changes - and the list has to be collected again. Either way the log
+  // starts over from the current generation.
+  bool takeTextBoxChanges(uint64_t since, std::vector<RenderBox *> &changes) {
+    bool known = since != 0 && since == textBoxChangesBase;
+    if (known) changes = std::move(textBoxChanges);
+    textBoxChanges.clear();
+    textBoxChangesBase = textBoxGeneration;
+    return known;
+  }
+
   void buildAndLayout(std::shared_ptr<Node> domRoot, float screenWidth,
                       StyleSheet &styleSheet, MSDFFontManager *fontManager) {
     viewportWidth = screenWidth;
     styleSheet.setViewport(viewportWidth, viewportHeight);
+    arena = std::make_shared<RenderArena>();
+    boxCount = 0;
     root = build(domRoot);
+    dirtyRelayoutRoots.clear();
+    geometryValid = false;
+    stackingValid = false;
+    layersValid = false;
+    textBoxGeneration = ++textBoxGenerationCounter;
+    textBoxChanges.clear();
+    textBoxChangesBase = 0;
+    RenderBox::layoutPass = {LAZY_LAYOUT_BUDGET, false, false, false, {}, false, false, false, false, false};
+    RenderBox::layoutPass.abort = abortFlag;
     root->layout(0, 0, screenWidth, styleSheet, fontManager, viewportWidth,
                  viewportHeight, false, 0.0f);
   }
 
-  // relayout with viewport scroll position for off-screen optimization
+  // relayout with viewport scroll position (drives content-visibility:auto)
+  // timeBudgetMs > 0 makes this one slice of a time-sliced layout: content in the
+  // viewport is always finished, then deferred off-screen block subtrees are laid
+  // out in document order until the budget runs out. The rest stays deferred
+  // (see hasPendingLayout) and the next call picks it up.
   void relayout(float screenWidth, float screenHeight, StyleSheet &styleSheet, 
-                MSDFFontManager *fontManager, float viewportScrollY = 0.0f) {
+                MSDFFontManager *fontManager, float viewportScrollY = 0.0f,
+                float timeBudgetMs = 0.0f) {
     if (root) {
       viewportWidth = screenWidth;
       viewportHeight = screenHeight;
       styleSheet.setViewport(viewportWidth, viewportHeight);
+
+      bool timeSliced = timeBudgetMs > 0;
+      auto deadline = std::chrono::steady_clock::now() +
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<float, std::milli>(timeBudgetMs));
+      RenderBox::layoutPass = {LAZY_LAYOUT_BUDGET, false, timeSliced, timeSliced, deadline,
+                               false, false, false, false, false};
+      RenderBox::layoutPass.abort = abortFlag;
       root->layout(0, 0, screenWidth, styleSheet, fontManager, viewportWidth,
                    viewportHeight, false, viewportScrollY);
+      layoutDirtyBoundaries(styleSheet, fontManager, viewportScrollY);
+
+      // Viewport done - spend what's left of the slice on deferred content
+      auto &pass = RenderBox::layoutPass;
+      while (timeSliced && pass.deferredPending && !pass.aborted() &&
+             (!pass.madeProgress || std::chrono::steady_clock::now() < deadline)) {
+        pass.viewportFirst = false;
+        pass.deferredPending = false;
+        root->layout(0, 0, screenWidth, styleSheet, fontManager, viewportWidth,
+                     viewportHeight, false, viewportScrollY);
+      }
+
+      // The spatial index and paint layers only go stale if something actually moved
+      if (pass.geometryChanged) geometryValid = layersValid = false;
+      if (pass.textBoxesChanged) {
+        textBoxGeneration = ++textBoxGenerationCounter;
+        textBoxChanges.insert(textBoxChanges.end(), pass.textBoxChanges.begin(),
+                              pass.textBoxChanges.end());
+        if (textBoxChanges.size() > MAX_TEXT_BOX_CHANGES) {
+          textBoxChanges.clear();
+          textBoxChangesBase = 0;
+        }
+      }
+      if (pass.paintOrderChanged) stackingValid = layersValid = false;
+    }
+  }
+
+  // Mark a box dirty after its content changed. The next relayout restarts from
+  // the nearest relayout boundary above it instead of from the root.
+  void markNeedsLayout(const std::shared_ptr<RenderBox> &box) {
+    if (box) dirtyRelayoutRoots.push_back(box->markNeedsLayout());
+  }
+
+  // Same, after the box's own style changed: descendants inherit from it and its
+  // own size may change, so the search for a boundary starts at its parent
+  void markStyleChanged(const std::shared_ptr<RenderBox> &box) {
+    if (!box) return;
+    box->invalidateLayoutCache();
+    auto parentBox = box->parent.lock();
+    markNeedsLayout(parentBox ? parentBox : box);
+  }
+
+  // Find the render box generated for a DOM node
+  std::shared_ptr<RenderBox> findBox(const std::shared_ptr<Node> &target) const {
+    if (!root || !target) return nullptr;
+    std::vector<std::shared_ptr<RenderBox>> stack{root};
+    while (!stack.empty()) {
+      auto box = stack.back();
+      stack.pop_back();
+      if (box->node == target) return box;
+      for (auto &child : box->children) stack.push_back(child);
+    }
+    return nullptr;
+  }
+
+  // Lay out boundaries still dirty after the root pass (which stops at clean
+  // ancestors), in place - their position and width can't have changed
+  void layoutDirtyBoundaries(StyleSheet &styleSheet, MSDFFontManager *fontManager,
+                             float viewportScrollY) {
+    for (auto &weakBoundary : dirtyRelayoutRoots) {
+      auto boundary = weakBoundary.lock();
+      if (!boundary || boundary->layoutCacheValid || boundary->lastLayoutWidth < LayoutUnit()) continue;
+
+      // Nothing to do inside display:none, skipped or deferred content
+      bool inLaidOutContent = true;
+      for (auto box = boundary->parent.lock(); box; box = box->parent.lock()) {
+        if (!box->childrenLaidOut() || box->computedStyle.display == DisplayType::Hidden) {
+          inLaidOutContent = false;
+          break;
+        }
+      }
+      if (!inLaidOutContent) continue;
+
+      boundary->layout(boundary->lastLayoutX.toPx(), boundary->lastLayoutY.toPx(),
+                       boundary->lastLayoutWidth.toPx(),
+                       styleSheet, fontManager, viewportWidth, viewportHeight, false,
+                       viewportScrollY);
+      for (auto box = boundary->parent.lock(); box; box = box->parent.lock()) {
+        if (boundary->subtreeHasLazyContent) box->subtreeHasLazyContent = true;
+        if (boundary->subtreeHasDeferredLayout) box->subtreeHasDeferredLayout = true;
+        if (boundary->subtreeHasPaintLayer) box->subtreeHasPaintLayer = true;
+        box->updateOverflow();
+      }
+    }
+    dirtyRelayoutRoots.clear();
+  }
+
+  // Geometry and spatial index of the last layout, rebuilt on first use after
+  // a pass that changed any box, with its scopes placed for the given page
+  // scroll (paint layers where they're drawn, scroll containers as they are).
+  // Scopes are placed again only when the paint layers were.
+  const BoxGeometryTable &geometry(float pageScrollX, float pageScrollY) {
+    if (!geometryValid) {
+      geometryTable.rebuild(root.get(), boxCount);
+      geometryValid = true;
+      placedLayersVersion = 0;
+    }
+    const auto &layers = paintLayers(pageScrollX, pageScrollY);
+    if (placedLayersVersion != layersVersion) {
+      geometryTable.place([&](const RenderBox *box) -> const PaintLayer * {
+        if (box->paintLayerIndex < 0 || (size_t)box->paintLayerIndex >= layers.size()) return nullptr;
+        const PaintLayer &layer = layers[box->paintLayerIndex];
+        return layer.box == box ? &layer : nullptr;
+      });
+      placedLayersVersion = layersVersion;
+    }
+    return geometryTable;
+  }
+
+  // Topmost box whose border box contains (x, y), y being in viewport space;
+  // scroll containers offset their descendants. Like walking children last to
+  // first, a box only counts if all its ancestors contain the point too.
+  std::shared_ptr<RenderBox> findBoxAtPoint(float x, float y, float scrollOffsetY = 0,
+                                            float scrollOffsetX = 0) {
+    // Paint layers are hit-tested where they're drawn, topmost first
+    const auto &table = geometry(scrollOffsetX, scrollOffsetY);
+    uint32_t hit = table.boxAt(x + scrollOffsetX, y + scrollOffsetY);
+    return hit != BoxGeometryTable::NONE ? table.boxes[hit]->shared_from_this() : nullptr;
+  }
+
+  // Innermost scrollable box at or above the box under (x, y), same
+  // coordinates as findBoxAtPoint; chain gets it and its scrollable
+  // ancestors, innermost first (for scroll propagation)
+  std::shared_ptr<RenderBox> findScrollableBoxAt(float x, float y, float scrollOffsetY,
+                                                 float scrollOffsetX,
+                                                 std::vector<std::shared_ptr<RenderBox>> *chain) {
+    std::shared_ptr<RenderBox> innermost;
+    for (auto box = findBoxAtPoint(x, y, scrollOffsetY, scrollOffsetX); box;
+         box = box->parent.lock()) {
+      if (!box->isScrollable()) continue;
+      if (!innermost) innermost = box;
+      if (chain) chain->push_back(box);
+    }
+    return innermost;
+  }
+
+  // Arena bytes per render box (control block included)
+  float bytesPerBox() const {
+    return boxCount && arena ? (float)arena->bytesAllocated / (float)boxCount : 0.0f;
+  }
+
+  // True if the last pass left work for another one: content-visibility:auto
+  // content near the viewport skipped for lack of budget, or deferred subtrees
+  bool hasPendingLayout() const {
+    return RenderBox::layoutPass.lazyPending || RenderBox::layoutPass.deferredPending;
+  }
+
+  // True if scrolling the page can change layout: some content-visibility:auto
+  // or deferred content is waiting for the viewport. Otherwise scrolling is
+  // compositing only.
+  bool layoutDependsOnScroll() const {
+    return root && (root->subtreeHasLazyContent || root->subtreeHasDeferredLayout);
+  }
+
+  // A stacking context (CSS 2.1 appendix E, simplified) with its z-order lists:
+  // child contexts with negative z-index, painted before its box and normal
+  // flow; positioned descendants with z-index auto or 0 and translucent boxes,
+  // in tree order; and child contexts with positive z-index. The z-index lists
+  // are sorted, ties in tree order. Layers of a child context are in its lists.
+  struct StackingContext {
+    RenderBox *box;
+    std::vector<RenderBox *> negativeZ;
+    std::vector<RenderBox *> positioned;
+    std::vector<RenderBox *> positiveZ;
+  };
+
+  // The stacking context tree, root's first; each context box has its
+  // stackingContextIndex. Built on first use after a pass that changed a box's
+  // position, z-index, opacity or display, or skipped or deferred a subtree.
+  const std::vector<StackingContext> &stackingContexts() {
+    if (!stackingValid) {
+      stacking.clear();
+      layerPaintOrder.clear();
+      layersBeneathFlow = 0;
+      layerCount = 0;
+      if (root) {
+        root->stackingContextIndex = 0;
+        stacking.push_back({root.get(), {}, {}, {}});
+        buildStacking(root.get(), 0);
+        auto byZ = [](const RenderBox *a, const RenderBox *b) {
+          return a->computedStyle.zIndex < b->computedStyle.zIndex;
+        };
+        for (auto &context : stacking) {
+          std::stable_sort(context.negativeZ.begin(), context.negativeZ.end(), byZ);
+          std::stable_sort(context.positiveZ.begin(), context.positiveZ.end(), byZ);
+        }
+        for (RenderBox *box : stacking[0].negativeZ) flattenPaintOrder(box);
+        layersBeneathFlow = layerPaintOrder.size();
+        for (RenderBox *box : stacking[0].positioned) flattenPaintOrder(box);
+        for (RenderBox *box : stacking[0].positiveZ) flattenPaintOrder(box);
+      }
+      stackingValid = true;
     }
+    return stacking;
   }
+
+  // A paint layer as drawn this frame. Its subtree is laid out in place and
+  // painted translated by offset (from layout to page coordinates, ancestor
+  // scroll offsets and fixed/sticky movement included), inside clip (page
+  // coordinates) if clipped. order is its place in paint order: the root's
+  // normal flow is 0, layers beneath it count down from -1 and the others up
+  // from 1. box is null for a layer that wasn't reached.
+  struct PaintLayer {
+    RenderBox *box = nullptr;
+    float offsetX = 0.0f, offsetY = 0.0f;
+    Rect clip;
+    bool clipped = false;
+    int order = 0;
+  };
+
+  // Every paint layer, indexed by paintLayerIndex, placed for the given page
+  // scroll. Nothing is laid out: fixed boxes move with the page scroll and
+  // sticky constraints are resolved from the scroll offsets alone. The list
+  // is kept until layout, the viewport or a scroll offset changes, so a frame's
+  // paint and the hit tests between frames share one walk.
+  const std::vector<PaintLayer> &paintLayers(float pageScrollX, float pageScrollY) {
+    stackingContexts();
+    LayersKey key{pageScrollX, pageScrollY, viewportWidth, viewportHeight,
+                  RenderBox::scrollGeneration.load(std::memory_order_relaxed)};
+    if (layersValid && key == layersKey) return cachedLayers;
+
+    cachedLayers.assign(layerCount, {});
+    if (root) {
+      LayerState state{pageScrollX, pageScrollY, 0.0f, 0.0f, {}, false,
+                       {pageScrollX, pageScrollY, viewportWidth, viewportHeight}};
+      collectLayers(root.get(), state, cachedLayers);
+    }
+    for (size_t i = 0; i < layerPaintOrder.size(); ++i) {
+      PaintLayer &layer = cachedLayers[layerPaintOrder[i]->paintLayerIndex];
+      layer.order = i < layersBeneathFlow ? (int)i - (int)layersBeneathFlow
+                                          : (int)(i - layersBeneathFlow) + 1;
+    }
+    layersKey = key;
+    layersValid = true;
+    ++layersVersion;
+    return cachedLayers;
+  }
+
+private:
+  // Stacking contexts below box's normal flow, and its layers in tree order
+  void buildStacking(RenderBox *box, size_t context) {
+    if (!box->childrenLaidOut()) return;
+    for (auto &childPtr : box->children) {
+      RenderBox *child = childPtr.get();
+      if (child->computedStyle.display == DisplayType::Hidden) continue;
+      bool layer = child->isPaintLayer();
+      if (!layer && !child->subtreeHasPaintLayer) continue;
+      size_t childContext = context;
+      if (layer) {
+        child->paintLayerIndex = layerCount++;
+        child->stackingContextIndex = -1;
+        int z = 0;
+        if (child->createsStackingContext()) {
+          z = child->computedStyle.zIndex;
+          childContext = stacking.size();
+          child->stackingContextIndex = (int)childContext;
+          stacking.push_back({child, {}, {}, {}});
+        }
+        auto &lists = stacking[context];
+        (z < 0 ? lists.negativeZ : z > 0 ? lists.positiveZ : lists.positioned).push_back(child);
+      }
+      buildStacking(child, childContext);
+    }
+  }
+
+  // Append a layer, and the layers of the context it creates, in paint order
+  void flattenPaintOrder(RenderBox *box) {
+    if (box->stackingContextIndex < 0) {
+      layerPaintOrder.push_back(box);
+      return;
+    }
+    const auto &context = stacking[box->stackingContextIndex];
+    for (RenderBox *layer : context.negativeZ) flattenPaintOrder(layer);
+    layerPaintOrder.push_back(box);
+    for (RenderBox *layer : context.positioned) flattenPaintOrder(layer);
+    for (RenderBox *layer : context.positiveZ) flattenPaintOrder(layer);
+  }
+
+  // Walk state for paintLayers: translation and clip so far, and the
+  // visible area of the nearest scroll container (the page, a scrolling box
+  // or, below a fixed box, the viewport) in the current layout coordinates
+  struct LayerState {
+    float pageScrollX, pageScrollY;
+    float offsetX, offsetY;
+    Rect clip;
+    bool clipped;
+    Rect scrollport;
+  };
+
+  // Same walk as buildStacking
+  void collectLayers(RenderBox *box, LayerState state, std::vector<PaintLayer> &layers) const {
+    if (box->computedStyle.display == DisplayType::Hidden) return;
+    if (!box->subtreeHasPaintLayer && !box->isPaintLayer()) return;
+    if (box->isFixedPosition()) {
+      auto [dx, dy] = box->fixedAnchorOffset(viewportWidth, viewportHeight);
+      state.offsetX = state.pageScrollX + dx;
+      state.offsetY = state.pageScrollY + dy;
+      state.clipped = false;
+      state.scrollport = {0, 0, viewportWidth, viewportHeight};
+    } else if (box->isStickyPosition()) {
+      auto [dx, dy] = stickyOffset(box, state.scrollport);
+      state.offsetX += dx;
+      state.offsetY += dy;
+      state.scrollport.x -= dx;
+      state.scrollport.y -= dy;
+    }
+    if (box->isPaintLayer() && box->paintLayerIndex >= 0 &&
+        (size_t)box->paintLayerIndex < layers.size()) {
+      layers[box->paintLayerIndex] = {box, state.offsetX, state.offsetY, state.clip, state.clipped};
+    }
+    if (!box->childrenLaidOut()) return;
+
+    // Same clip and scroll translation as paint() applies to the children
+    const auto &style = box->computedStyle;
+    const Rect &content = box->box.content;
+    if (style.overflow != Overflow::Visible || style.containPaint) {
+      Rect clip{content.x + state.offsetX, content.y + state.offsetY, content.width, content.height};
+      if (state.clipped) {
+        float left = std::max(clip.x, state.clip.x);
+        float top = std::max(clip.y, state.clip.y);
+        clip = {left, top, std::min(clip.right(), state.clip.right()) - left,
+                std::min(clip.bottom(), state.clip.bottom()) - top};
+      }
+      state.clip = clip;
+      state.clipped = true;
+    }
+    if (style.overflow == Overflow::Scroll || style.overflow == Overflow::Auto) {
+      state.scrollport = {content.x + box->scrollX, content.y + box->scrollY,
+                          content.width, content.height};
+    }
+    if (box->isScrollable()) {
+      state.offsetX -= box->scrollX;
+      state.offsetY -= box->scrollY;
+    }
+    for (auto &child : box->children) collectLayers(child.get(), state, layers);
+  }
+
+  // How far a sticky box moves from its laid-out position to keep its top/left
+  // (or bottom/right) inset inside the scrollport, without leaving its
+  // containing block. Table rows and row groups don't contain a sticky cell; the
+  // table does.
+  static std::pair<float, float> stickyOffset(const RenderBox *box, const Rect &scrollport) {
+    auto block = box->parent.lock();
+    while (block && (block->tag == "tr" || block->tag == "tbody" || block->tag == "thead" ||
+                     block->tag == "tfoot")) {
+      block = block->parent.lock();
+    }
+    Rect border = box->box.borderBox();
+    Rect limit = block ? block->box.content : border;
+    const auto &style = box->computedStyle;
+    float fontSize = style.fontSize;
+
+    auto resolve = [&](const CssValue &inset, const CssValue &opposite, float start, float end,
+                       float scrollStart, float scrollEnd, float limitStart, float limitEnd) {
+      float delta = 0.0f;
+      if (!inset.isAuto()) {
+        float minStart = scrollStart + RenderBox::insetPx(inset, scrollEnd - scrollStart, fontSize,
+                                                          scrollport.width, scrollport.height);
+        if (start < minStart) delta = std::min(minStart - start, std::max(0.0f, limitEnd - end));
+      } else if (!opposite.isAuto()) {
+        float maxEnd = scrollEnd - RenderBox::insetPx(opposite, scrollEnd - scrollStart, fontSize,
+                                                      scrollport.width, scrollport.height);
+        if (end > maxEnd) delta = std::max(maxEnd - end, std::min(0.0f, limitStart - start));
+      }
+      return delta;
+    };
+    float dx = resolve(style.left, style.right_, border.x, border.right(), scrollport.x,
+                       scrollport.right(), limit.x, limit.right());
+    float dy = resolve(style.top, style.bottom, border.y, border.bottom(), scrollport.y,
+                       scrollport.bottom(), limit.y, limit.bottom());
+    return {dx, dy};
+  }
+
+  BoxGeometryTable geometryTable;
+  bool geometryValid = false;
+  // Behind paintLayers: what cachedLayers was placed for
+  struct LayersKey {
+    float pageScrollX, pageScrollY, viewportWidth, viewportHeight;
+    uint64_t scrollGeneration;
+    bool operator==(const LayersKey &) const = default;
+  };
+  std::vector<PaintLayer> cachedLayers;
+  LayersKey layersKey{};
+  bool layersValid = false;
+  uint64_t layersVersion = 0;        // Moves on every time cachedLayers is placed
+  uint64_t placedLayersVersion = 0;  // The one geometryTable was placed for
+  std::vector<StackingContext> stacking;
+  std::vector<RenderBox *> layerPaintOrder;  // Every layer but the root's, in paint order
+  size_t layersBeneathFlow = 0;              // Leading layerPaintOrder entries under the root's flow
+  int layerCount = 0;
+  bool stackingValid = false;
+  // Log behind takeTextBoxChanges: subtrees changed since textBoxChangesBase
+  std::vector<RenderBox *> textBoxChanges;
+  uint64_t textBoxChangesBase = 0;
+  static inline std::atomic<uint64_t> textBoxGenerationCounter{0};
 };
 
 } // namespace skene
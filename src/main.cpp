@@ -5,12 +5,14 @@
 // Undefine after include to prevent the implementation from being compiled again
 #undef STB_TRUETYPE_IMPLEMENTATION
 
+#include "layout/LayoutWorker.hpp"
 #include "layout/RenderTree.hpp"
 #include "parser/HtmlParser.hpp"
 #include "render/Renderer.hpp"
 #include "style/StyleSheet.hpp"
 #include <SDL.h>
 #include <SDL_opengl.h>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <limits>
@@ -33,6 +35,7 @@ skene::Renderer* g_renderer = nullptr;
 skene::RenderTree* g_renderTree = nullptr;
 skene::StyleSheet* g_styleSheet = nullptr;
 skene::MSDFFontManager* g_fontManager = nullptr;  // MSDF font manager for sharp text
+skene::LayoutWorker* g_layoutWorker = nullptr;  // Lays out for new window sizes off the main thread
 std::shared_ptr<skene::Node> g_dom = nullptr;
 bool g_needsRender = false;
 bool g_needsLayout = false;  // Only relayout when content changes
@@ -80,11 +83,15 @@ bool shiftKeyPressed = false;
 Uint32 lastResizeLayoutTime = 0;
 const Uint32 RESIZE_LAYOUT_INTERVAL = 50;  // ms between relayouts during resize
 
+// Time-sliced layout: each frame lays out the viewport plus this much more
+const float LAYOUT_SLICE_MS = 4.0f;
+
 // Debug/FPS tracking
 Uint32 fpsLastTime = 0;
 int fpsFrameCount = 0;
 float fpsCurrent = 0.0f;
 float frameTimeMs = 0.0f;
+float paintWalkMs = 0.0f;  // paint() over the render tree, last frame
 Uint32 frameStartTime = 0;
 const float SCROLL_SPEED = 40.0f;
 
@@ -244,7 +251,7 @@ bool isDescendantOf(std::shared_ptr<skene::Node> node, std::shared_ptr<skene::No
 // Find all text boxes that belong to the same block-level element
 std::pair<std::shared_ptr<skene::RenderBox>, std::shared_ptr<skene::RenderBox>> 
 findBlockTextBoxRange(std::shared_ptr<skene::RenderBox> clickedBox,
-                      const std::vector<std::shared_ptr<skene::RenderBox>> &allTextBoxes) {
+                      const skene::TextSelection &sel) {
   if (!clickedBox || !clickedBox->node) {
     return {clickedBox, clickedBox};
   }
@@ -256,21 +263,21 @@ findBlockTextBoxRange(std::shared_ptr<skene::RenderBox> clickedBox,
     return {clickedBox, clickedBox};
   }
   
-  // Find all text boxes that are descendants of this block ancestor
-  std::shared_ptr<skene::RenderBox> firstBox = nullptr;
-  std::shared_ptr<skene::RenderBox> lastBox = nullptr;
-  
-  for (const auto &box : allTextBoxes) {
-    if (box->node && isDescendantOf(box->node, blockAncestor)) {
-      if (!firstBox) firstBox = box;
-      lastBox = box;
-    }
+  // The block's text boxes are next to each other in document order, so grow
+  // the range outward from the clicked box
+  const auto &allTextBoxes = sel.allTextBoxes;
+  int first = sel.getBoxIndex(clickedBox);
+  if (first < 0) return {clickedBox, clickedBox};
+  int last = first;
+  while (first > 0 && isDescendantOf(allTextBoxes[first - 1]->node, blockAncestor)) {
+    --first;
+  }
+  while (last + 1 < (int)allTextBoxes.size() &&
+         isDescendantOf(allTextBoxes[last + 1]->node, blockAncestor)) {
+    ++last;
   }
   
-  if (!firstBox) firstBox = clickedBox;
-  if (!lastBox) lastBox = clickedBox;
-  
-  return {firstBox, lastBox};
+  return {allTextBoxes[first], allTextBoxes[last]};
 }
 
 // Find link (<a>) ancestor of a node and return its href
@@ -301,30 +308,6 @@ bool isInsideLink(std::shared_ptr<skene::RenderBox> box) {
   return !findLinkHref(box->node).empty();
 }
 
-// Find the RenderBox at a point (for hover detection)
-std::shared_ptr<skene::RenderBox> findBoxAtPoint(
-    std::shared_ptr<skene::RenderBox> box, float x, float y, float scrollOffsetY = 0) {
-  if (!box) return nullptr;
-  
-  float adjustedY = y + scrollOffsetY;
-  skene::Rect borderBox = box->box.borderBox();
-  
-  bool inBounds = x >= borderBox.x && x < borderBox.x + borderBox.width &&
-                  adjustedY >= borderBox.y && adjustedY < borderBox.y + borderBox.height;
-  
-  if (!inBounds) return nullptr;
-  
-  // Check children first (reverse order for z-order)
-  for (auto it = box->children.rbegin(); it != box->children.rend(); ++it) {
-    float childScrollY = scrollOffsetY + box->scrollY;
-    auto result = findBoxAtPoint(*it, x, y, childScrollY);
-    if (result) return result;
-  }
-  
-  // Return this box if we're in bounds
-  return box;
-}
-
 // Collect all text boxes in document order (recursive)
 void collectTextBoxes(std::shared_ptr<skene::RenderBox> box, 
                       std::vector<std::shared_ptr<skene::RenderBox>> &textBoxes,
@@ -351,49 +334,102 @@ void collectTextBoxes(std::shared_ptr<skene::RenderBox> box,
     }
   }
   
+  if (!box->childrenLaidOut()) return;  // Skipped or deferred, no current layout
+  
   for (auto &child : box->children) {
     collectTextBoxes(child, textBoxes, debug);
   }
 }
 
-// Helper function to find text box at exact point (recursive)
-std::shared_ptr<skene::RenderBox> findTextBoxAtExact(
-    std::shared_ptr<skene::RenderBox> box, float x, float y, skene::MSDFFontManager &fontManager,
-    size_t &lineIndex, size_t &charIndex) {
-  if (!box) return nullptr;
-  
-  // Check children first (front-to-back, but reversed for proper z-order)
-  for (auto it = box->children.rbegin(); it != box->children.rend(); ++it) {
-    auto result = findTextBoxAtExact(*it, x, y, fontManager, lineIndex, charIndex);
-    if (result) return result;
-  }
-  
-  // Check this box's text
-  if (box->node && box->node->type == skene::NodeType::Text && !box->textLines.empty()) {
-    float fontSize = box->computedStyle.fontSize;
-    skene::MSDFFont* font = fontManager.getFont(box->computedStyle.fontFamily, 
-        static_cast<int>(box->computedStyle.fontWeight), static_cast<int>(box->computedStyle.fontStyle));
-    if (!font) return nullptr;
-    
-    // Check if point is within any text line's bounding area
-    for (size_t i = 0; i < box->textLines.size(); ++i) {
-      const auto &line = box->textLines[i];
-      // Check both vertical AND horizontal bounds
-      float lineTop = line.y;
-      float lineBottom = line.y + line.height;
-      float lineLeft = line.x;
-      float lineRight = line.x + line.width;
-      
-      if (y >= lineTop && y < lineBottom && x >= lineLeft && x < lineRight) {
-        lineIndex = i;
-        float localX = x - line.x;
-        charIndex = font->hitTestText(line.text, std::max(0.0f, localX), fontSize);
-        return box;
+// Bring the selection's text box list up to date with the render tree. Most
+// layouts (scrolling, re-slicing, style tweaks) leave the set of text boxes
+// alone, and then the current list and its indices are kept. Otherwise only
+// the subtrees the tree logged as changed are collected again and spliced in;
+// a new tree, or one that changed too much, is collected whole.
+void updateTextBoxes(skene::RenderTree &renderTree, bool debug = false) {
+  if (textSelection.textBoxGeneration == renderTree.textBoxGeneration) return;
+  std::vector<skene::RenderBox *> changes;
+  if (renderTree.takeTextBoxChanges(textSelection.textBoxGeneration, changes) && !debug) {
+    // Outermost subtrees first; nested ones are collected with them
+    std::sort(changes.begin(), changes.end(), [](const skene::RenderBox *a, const skene::RenderBox *b) {
+      return a->treeOrder < b->treeOrder;
+    });
+    uint32_t collectedEnd = 0;
+    for (skene::RenderBox *subtree : changes) {
+      if (subtree->treeOrder < collectedEnd) continue;
+      collectedEnd = subtree->treeOrderEnd;
+      bool laidOut = true;
+      for (auto ancestor = subtree->parent.lock(); ancestor && laidOut; ancestor = ancestor->parent.lock()) {
+        laidOut = ancestor->childrenLaidOut();
       }
+      std::vector<std::shared_ptr<skene::RenderBox>> textBoxes;
+      if (laidOut) collectTextBoxes(subtree->shared_from_this(), textBoxes);
+      textSelection.replaceTextBoxes(subtree->treeOrder, subtree->treeOrderEnd, std::move(textBoxes));
     }
+    textSelection.textBoxGeneration = renderTree.textBoxGeneration;
+    return;
   }
-  
-  return nullptr;
+  std::vector<std::shared_ptr<skene::RenderBox>> textBoxes;
+  textBoxes.reserve(textSelection.allTextBoxes.size());
+  collectTextBoxes(renderTree.root, textBoxes, debug);
+  textSelection.setTextBoxes(std::move(textBoxes), renderTree.textBoxGeneration);
+}
+
+// Lay the page out for the current window size on the layout worker. Frames keep
+// painting the current tree until adoptLayoutSnapshot swaps the new one in.
+void requestLayoutSnapshot() {
+  if (!g_layoutWorker || !g_dom || !g_styleSheet) return;
+  g_layoutWorker->request(g_dom, *g_styleSheet, (float)(screenWidth - INSPECTOR_WIDTH),
+                          (float)screenHeight, scrollY);
+}
+
+// Carry state the main thread keeps on boxes (scroll offsets, selection ends)
+// over to the matching boxes of a tree built from the same DOM
+void transferBoxState(skene::RenderBox *from, skene::RenderBox *to) {
+  if (from->node != to->node) return;
+  to->scrollTo(from->scrollX, from->scrollY);
+  if (textSelection.anchorBox.get() == from) textSelection.anchorBox = to->shared_from_this();
+  if (textSelection.focusBox.get() == from) textSelection.focusBox = to->shared_from_this();
+  if (from->children.size() != to->children.size()) return;
+  for (size_t i = 0; i < from->children.size(); i++) {
+    transferBoxState(from->children[i].get(), to->children[i].get());
+  }
+}
+
+// Swap in the tree the layout worker finished, if any. The replaced tree is
+// destroyed on the worker.
+void adoptLayoutSnapshot(skene::RenderTree &renderTree) {
+  auto next = g_layoutWorker ? g_layoutWorker->takeResult() : nullptr;
+  if (!next) return;
+  if (renderTree.root && next->root) transferBoxState(renderTree.root.get(), next->root.get());
+  auto replaced = std::make_shared<skene::RenderTree>(std::move(renderTree));
+  renderTree = std::move(*next);
+  g_layoutWorker->retire(std::move(replaced));
+  updateTextBoxes(renderTree);
+  g_needsLayout = true;  // Pick up scroll-dependent work (content-visibility:auto) here
+}
+
+// Helper function to find text box at exact point (page coordinates), through
+// the render tree's spatial index. The last text box in document order wins.
+std::shared_ptr<skene::RenderBox> findTextBoxAtExact(
+    float x, float y, skene::MSDFFontManager &fontManager,
+    size_t &lineIndex, size_t &charIndex) {
+  if (!g_renderTree || !g_renderTree->root) return nullptr;
+  
+  auto hit = g_renderTree->geometry(scrollX, scrollY).textLineAt(x, y);
+  if (!hit.box) return nullptr;
+  
+  auto *box = hit.box;
+  float fontSize = box->computedStyle.fontSize;
+  skene::MSDFFont* font = skene::fontForStyle(&fontManager, box->computedStyle);
+  if (!font) return nullptr;
+  
+  // hit.localX is x in the line's coordinates (inside scroll containers)
+  const auto &line = box->textLines[hit.lineIndex];
+  lineIndex = hit.lineIndex;
+  float localX = hit.localX - line.x;
+  charIndex = font->hitTestText(line.text, std::max(0.0f, localX), fontSize);
+  return box->shared_from_this();
 }
 
 // Find text box at vertical position during drag selection
@@ -403,9 +439,11 @@ std::shared_ptr<skene::RenderBox> findTextBoxAtY(
     float x, float y, skene::MSDFFontManager &fontManager,
     size_t &lineIndex, size_t &charIndex) {
   
-  if (textSelection.allTextBoxes.empty()) return nullptr;
+  if (!g_renderTree || !g_renderTree->root) return nullptr;
+  const auto &index = g_renderTree->geometry(scrollX, scrollY);
   
-  // First, collect all text lines that intersect this Y position
+  // First, collect all text lines that intersect this Y position (x is in
+  // page coordinates, so lines inside scroll containers appear where painted)
   struct LineCandidate {
     std::shared_ptr<skene::RenderBox> box;
     size_t lineIdx;
@@ -413,26 +451,17 @@ std::shared_ptr<skene::RenderBox> findTextBoxAtY(
   };
   std::vector<LineCandidate> candidatesAtY;
   
-  for (auto &box : textSelection.allTextBoxes) {
-    if (box->textLines.empty()) continue;
-    
-    for (size_t i = 0; i < box->textLines.size(); ++i) {
-      const auto &line = box->textLines[i];
-      float lineTop = line.y;
-      float lineBottom = line.y + line.height;
-      
-      // Check if Y is within this line's vertical bounds
-      if (y >= lineTop && y < lineBottom) {
-        candidatesAtY.push_back({box, i, line.x, line.width});
-      }
-    }
+  for (const auto &hit : index.textLinesAtY(x, y)) {
+    const auto &line = hit.box->textLines[hit.lineIndex];
+    candidatesAtY.push_back({hit.box->shared_from_this(), hit.lineIndex,
+                             line.x - (hit.localX - x), line.width});
   }
   
   // If we have candidates at this Y, find the one at X position
   if (!candidatesAtY.empty()) {
-    // Sort by X position
-    std::sort(candidatesAtY.begin(), candidatesAtY.end(), 
-              [](const LineCandidate &a, const LineCandidate &b) { return a.x < b.x; });
+    // Sort by X position (document order among equals)
+    std::stable_sort(candidatesAtY.begin(), candidatesAtY.end(), 
+                     [](const LineCandidate &a, const LineCandidate &b) { return a.x < b.x; });
     
     // Find which text box the X falls into (or the gap before/after it)
     for (size_t i = 0; i < candidatesAtY.size(); ++i) {
@@ -445,9 +474,8 @@ std::shared_ptr<skene::RenderBox> findTextBoxAtY(
         lineIndex = cand.lineIdx;
         const auto &line = cand.box->textLines[cand.lineIdx];
         float fontSize = cand.box->computedStyle.fontSize;
-        skene::MSDFFont* font = fontManager.getFont(cand.box->computedStyle.fontFamily, 
-            static_cast<int>(cand.box->computedStyle.fontWeight), static_cast<int>(cand.box->computedStyle.fontStyle));
-        float localX = x - line.x;
+        skene::MSDFFont* font = skene::fontForStyle(&fontManager, cand.box->computedStyle);
+        float localX = x - cand.x;
         charIndex = font ? font->hitTestText(line.text, localX, fontSize) : 0;
         return cand.box;
       }
@@ -488,51 +516,29 @@ std::shared_ptr<skene::RenderBox> findTextBoxAtY(
   }
   
   // No line at this exact Y - find nearest by vertical distance only
-  float bestDist = std::numeric_limits<float>::max();
-  std::shared_ptr<skene::RenderBox> bestBox = nullptr;
-  size_t bestLineIdx = 0;
-  bool isBelowNearest = false;
-  
-  for (auto &box : textSelection.allTextBoxes) {
-    if (box->textLines.empty()) continue;
-    
-    for (size_t i = 0; i < box->textLines.size(); ++i) {
-      const auto &line = box->textLines[i];
-      float lineTop = line.y;
-      float lineBottom = line.y + line.height;
-      float lineMidY = (lineTop + lineBottom) / 2.0f;
-      
-      float dist = std::abs(y - lineMidY);
-      if (dist < bestDist) {
-        bestDist = dist;
-        bestBox = box;
-        bestLineIdx = i;
-        isBelowNearest = (y > lineBottom);
-      }
-    }
-  }
-  
-  if (bestBox) {
-    lineIndex = bestLineIdx;
-    const auto &line = bestBox->textLines[bestLineIdx];
+  auto nearest = index.textLineNearestY(x, y);
+  if (nearest.box) {
+    auto *bestBox = nearest.box;
+    lineIndex = nearest.lineIndex;
+    const auto &line = bestBox->textLines[nearest.lineIndex];
     float fontSize = bestBox->computedStyle.fontSize;
-    skene::MSDFFont* font = fontManager.getFont(bestBox->computedStyle.fontFamily, 
-        static_cast<int>(bestBox->computedStyle.fontWeight), static_cast<int>(bestBox->computedStyle.fontStyle));
+    skene::MSDFFont* font = skene::fontForStyle(&fontManager, bestBox->computedStyle);
     
     // If below the nearest line, anchor at end; if above, at start
-    if (isBelowNearest) {
+    float lineX = nearest.localX, lineY = nearest.localY;
+    if (lineY > line.y + line.height) {
       charIndex = line.text.length();
-    } else if (y < line.y) {
+    } else if (lineY < line.y) {
       charIndex = 0;
-    } else if (x <= line.x) {
+    } else if (lineX <= line.x) {
       charIndex = 0;
-    } else if (x >= line.x + line.width) {
+    } else if (lineX >= line.x + line.width) {
       charIndex = line.text.length();
     } else {
-      float localX = x - line.x;
+      float localX = lineX - line.x;
       charIndex = font ? font->hitTestText(line.text, localX, fontSize) : 0;
     }
-    return bestBox;
+    return bestBox->shared_from_this();
   }
   
   return nullptr;
@@ -548,61 +554,24 @@ std::shared_ptr<skene::RenderBox> findNearestTextBox(
     float x, float y, skene::MSDFFontManager &fontManager,
     size_t &lineIndex, size_t &charIndex) {
   
-  if (textSelection.allTextBoxes.empty()) return nullptr;
+  if (!g_renderTree || !g_renderTree->root) return nullptr;
   
-  std::shared_ptr<skene::RenderBox> bestBox = nullptr;
-  float bestDistance = std::numeric_limits<float>::max();
-  size_t bestLineIdx = 0;
-  bool isAbove = false;
-  bool isBelow = false;
-  bool isLeft = false;
-  bool isRight = false;
+  auto nearest = g_renderTree->geometry(scrollX, scrollY).nearestTextLine(x, y);
+  if (!nearest.box) return nullptr;
+  auto bestBox = nearest.box->shared_from_this();
   
-  for (auto &box : textSelection.allTextBoxes) {
-    if (box->textLines.empty()) continue;
-    
-    for (size_t i = 0; i < box->textLines.size(); ++i) {
-      const auto &line = box->textLines[i];
-      
-      // Calculate distance to this line
-      float lineTop = line.y;
-      float lineBottom = line.y + line.height;
-      float lineLeft = line.x;
-      float lineRight = line.x + line.width;
-      
-      // Vertical distance
-      float dy = 0;
-      bool above = false, below = false;
-      if (y < lineTop) { dy = lineTop - y; above = true; }
-      else if (y > lineBottom) { dy = y - lineBottom; below = true; }
-      
-      // Horizontal distance  
-      float dx = 0;
-      bool left = false, right = false;
-      if (x < lineLeft) { dx = lineLeft - x; left = true; }
-      else if (x > lineRight) { dx = x - lineRight; right = true; }
-      
-      float distance = dx * dx + dy * dy;
-      
-      if (distance < bestDistance) {
-        bestDistance = distance;
-        bestBox = box;
-        bestLineIdx = i;
-        isAbove = above;
-        isBelow = below;
-        isLeft = left;
-        isRight = right;
-      }
-    }
-  }
+  lineIndex = nearest.lineIndex;
+  const auto &bestLine = bestBox->textLines[nearest.lineIndex];
   
-  if (!bestBox || bestBox->textLines.empty()) return nullptr;
+  // Where the point lies relative to the line, in the line's coordinates
+  float lineX = nearest.localX, lineY = nearest.localY;
+  bool isAbove = lineY < bestLine.y;
+  bool isBelow = !isAbove && lineY > bestLine.y + bestLine.height;
+  bool isLeft = lineX < bestLine.x;
+  bool isRight = !isLeft && lineX > bestLine.x + bestLine.width;
   
-  lineIndex = bestLineIdx;
-  const auto &bestLine = bestBox->textLines[bestLineIdx];
   float fontSize = bestBox->computedStyle.fontSize;
-  skene::MSDFFont* font = fontManager.getFont(bestBox->computedStyle.fontFamily, 
-      static_cast<int>(bestBox->computedStyle.fontWeight), static_cast<int>(bestBox->computedStyle.fontStyle));
+  skene::MSDFFont* font = skene::fontForStyle(&fontManager, bestBox->computedStyle);
   
   // Determine character index based on position relative to nearest text
   if (isAbove) {
@@ -619,7 +588,7 @@ std::shared_ptr<skene::RenderBox> findNearestTextBox(
     charIndex = bestLine.text.length();
   } else {
     // Click is within bounds - use hit test
-    float localX = x - bestLine.x;
+    float localX = lineX - bestLine.x;
     charIndex = font ? font->hitTestText(bestLine.text, std::max(0.0f, localX), fontSize) : 0;
   }
   
@@ -628,11 +597,11 @@ std::shared_ptr<skene::RenderBox> findNearestTextBox(
 
 // Helper function to find text box at point, falling back to nearest
 std::shared_ptr<skene::RenderBox> findTextBoxAt(
-    std::shared_ptr<skene::RenderBox> box, float x, float y, skene::MSDFFontManager &fontManager,
+    float x, float y, skene::MSDFFontManager &fontManager,
     size_t &lineIndex, size_t &charIndex, bool allowNearest = false) {
   
   // First try exact match
-  auto result = findTextBoxAtExact(box, x, y, fontManager, lineIndex, charIndex);
+  auto result = findTextBoxAtExact(x, y, fontManager, lineIndex, charIndex);
   if (result) return result;
   
   // If allowNearest, find the closest text box
@@ -787,7 +756,8 @@ void paintStyles(skene::Renderer &renderer, skene::MSDFFontManager &fontManager,
                              0.0f, 0.0f, 1.0f);
 
     // Draw Style Content
-    std::string styleStr = selectedNode->attributes["style"];
+    auto styleAttr = selectedNode->attributes.find("style");  // Don't insert: the layout worker reads the DOM
+    std::string styleStr = styleAttr != selectedNode->attributes.end() ? styleAttr->second : "";
     if (font) {
       renderer.drawText(x + 15, currentY + 16, styleStr, *font, 0.0f, 0.0f, 0.0f,
                         1.0f);
@@ -902,6 +872,33 @@ void paintPerformanceView(skene::Renderer &renderer, skene::MSDFFontManager &fon
   renderer.drawText(valueX, currentY, buffer, *font, 0.0f, 0.0f, 0.0f, 1.0f, fontSize);
   currentY += lineHeight;
   
+  // Render boxes and their arena footprint
+  size_t boxCount = g_renderTree ? g_renderTree->boxCount : 0;
+  snprintf(buffer, sizeof(buffer), "%zu", boxCount);
+  renderer.drawText(labelX, currentY, "Render Boxes:", *font, 0.3f, 0.3f, 0.3f, 1.0f, fontSize);
+  renderer.drawText(valueX, currentY, buffer, *font, 0.0f, 0.0f, 0.0f, 1.0f, fontSize);
+  currentY += lineHeight;
+
+  snprintf(buffer, sizeof(buffer), "%.0f B", g_renderTree ? g_renderTree->bytesPerBox() : 0.0f);
+  renderer.drawText(labelX, currentY, "Bytes / Box:", *font, 0.3f, 0.3f, 0.3f, 1.0f, fontSize);
+  renderer.drawText(valueX, currentY, buffer, *font, 0.0f, 0.0f, 0.0f, 1.0f, fontSize);
+  currentY += lineHeight;
+
+  // Time spent walking the render tree in paint()
+  snprintf(buffer, sizeof(buffer), "%.2f ms", paintWalkMs);
+  renderer.drawText(labelX, currentY, "Paint Walk:", *font, 0.3f, 0.3f, 0.3f, 1.0f, fontSize);
+  renderer.drawText(valueX, currentY, buffer, *font, 0.0f, 0.0f, 0.0f, 1.0f, fontSize);
+  currentY += lineHeight;
+
+  // The fonts' word-width caches. Only long words (non-ASCII ones, URLs) are
+  // looked up, so this is their hit rate and count, not all words'.
+  auto wordCache = skene::WordWidthCache::stats();
+  snprintf(buffer, sizeof(buffer), "%.1f%% of %llu", wordCache.hitRate() * 100.0,
+           (unsigned long long)wordCache.lookups);
+  renderer.drawText(labelX, currentY, "Long Words:", *font, 0.3f, 0.3f, 0.3f, 1.0f, fontSize);
+  renderer.drawText(valueX, currentY, buffer, *font, 0.0f, 0.0f, 0.0f, 1.0f, fontSize);
+  currentY += lineHeight;
+
   // Inspector lines (DOM nodes visible)
   snprintf(buffer, sizeof(buffer), "%zu", inspectorLines.size());
   renderer.drawText(labelX, currentY, "DOM Nodes:", *font, 0.3f, 0.3f, 0.3f, 1.0f, fontSize);
@@ -1039,11 +1036,17 @@ void paintPerformanceView(skene::Renderer &renderer, skene::MSDFFontManager &fon
   renderer.drawText(sliderX + sliderWidth + 10, currentY + 10, valBuf, *font, 0.0f, 0.0f, 0.0f, 1.0f, fontSize);
 }
 
-// Draw selection highlights across all text boxes, filling gaps between inline elements
-void paintSelectionHighlights(skene::Renderer &renderer, skene::MSDFFontManager &fontManager) {
+// Draw selection highlights across all text boxes, filling gaps between inline elements.
+// Only the text lines within the cull rect are visited (through the render
+// tree's spatial index), so the cost doesn't grow with the selection.
+void paintSelectionHighlights(skene::Renderer &renderer, skene::RenderTree &renderTree,
+                              skene::MSDFFontManager &fontManager, const skene::Rect &cullRect) {
   if (!textSelection.hasSelection) {
     return;
   }
+  int anchorIdx = textSelection.getBoxIndex(textSelection.anchorBox);
+  int focusIdx = textSelection.getBoxIndex(textSelection.focusBox);
+  if (anchorIdx < 0 || focusIdx < 0) return;
   
   // Collect all selection segments with their positions
   struct SelectionSegment {
@@ -1053,33 +1056,34 @@ void paintSelectionHighlights(skene::Renderer &renderer, skene::MSDFFontManager
   // Group segments by Y position (same line)
   std::map<int, std::vector<SelectionSegment>> segmentsByLine;
   
-  for (size_t boxIdx = 0; boxIdx < textSelection.allTextBoxes.size(); ++boxIdx) {
-    auto &box = textSelection.allTextBoxes[boxIdx];
-    if (box->textLines.empty()) continue;
+  int firstIdx = std::min(anchorIdx, focusIdx);
+  int lastIdx = std::max(anchorIdx, focusIdx);
+  renderTree.geometry(scrollX, scrollY).forEachTextLineIn(cullRect.y, cullRect.bottom(),
+      [&](skene::RenderBox *textBox, size_t lineIdx, float offsetX, float offsetY) {
+    int boxIdx = textBox->textBoxIndex;
+    if (boxIdx < firstIdx || boxIdx > lastIdx) return;
+    const auto &box = textSelection.allTextBoxes[boxIdx];
+    if (box.get() != textBox) return;
     
-    skene::MSDFFont* font = fontManager.getFont(box->computedStyle.fontFamily, 
-        static_cast<int>(box->computedStyle.fontWeight), static_cast<int>(box->computedStyle.fontStyle));
-    if (!font) font = fontManager.getDefaultFont();
-    if (!font) continue;
+    skene::MSDFFont* font = skene::fontForStyle(&fontManager, box->computedStyle);
+    if (!font) return;
     
     float fontSize = box->computedStyle.fontSize;
+    const auto &line = box->textLines[lineIdx];
+    auto [selStart, selEnd] = textSelection.getSelectionRangeForLine(
+        box, lineIdx, line.text.length());
     
-    for (size_t lineIdx = 0; lineIdx < box->textLines.size(); ++lineIdx) {
-      const auto &line = box->textLines[lineIdx];
+    if (selStart < selEnd) {
+      float lineX = line.x + offsetX;
+      float lineY = line.y + offsetY;
+      float startX = lineX + font->getPositionAtIndex(line.text, selStart, fontSize);
+      float endX = lineX + font->getPositionAtIndex(line.text, selEnd, fontSize);
       
-      auto [selStart, selEnd] = textSelection.getSelectionRangeForLine(
-          box, lineIdx, line.text.length());
-      
-      if (selStart < selEnd) {
-        float startX = line.x + font->getPositionAtIndex(line.text, selStart, fontSize);
-        float endX = line.x + font->getPositionAtIndex(line.text, selEnd, fontSize);
-        
-        // Use Y position rounded to int as key for grouping lines
-        int lineKey = (int)(line.y * 10); // Multiply by 10 for sub-pixel grouping
-        segmentsByLine[lineKey].push_back({startX, line.y, endX - startX, line.height});
-      }
+      // Use Y position rounded to int as key for grouping lines
+      int lineKey = (int)(lineY * 10); // Multiply by 10 for sub-pixel grouping
+      segmentsByLine[lineKey].push_back({startX, lineY, endX - startX, line.height});
     }
-  }
+  });
   
   // For each line, sort segments by X and fill gaps
   for (auto &[lineKey, segments] : segmentsByLine) {
@@ -1108,87 +1112,44 @@ void paintSelectionHighlights(skene::Renderer &renderer, skene::MSDFFontManager
   }
 }
 
-// Find the deepest scrollable element containing the given point
-// Also returns the chain of scrollable ancestors for scroll propagation
-std::shared_ptr<skene::RenderBox> findScrollableElementAt(
-    std::shared_ptr<skene::RenderBox> box, float px, float py, float parentScrollX = 0, float parentScrollY = 0,
-    std::vector<std::shared_ptr<skene::RenderBox>>* scrollableChain = nullptr) {
-  if (!box) return nullptr;
-  
-  skene::Rect borderBox = box->box.borderBox();
-  
-  // Adjust point for parent scroll
-  float localPx = px + parentScrollX;
-  float localPy = py + parentScrollY;
-  
-  // Check if point is within this box's bounds
-  bool inBounds = localPx >= borderBox.x && localPx < borderBox.x + borderBox.width &&
-                  localPy >= borderBox.y && localPy < borderBox.y + borderBox.height;
-  
-  if (!inBounds) return nullptr;
-  
-  // Track if this element is scrollable (for building the chain)
-  bool thisIsScrollable = box->isScrollable();
-  
-  // Check children first (depth-first, inner elements take priority)
-  float childScrollX = parentScrollX + box->scrollX;
-  float childScrollY = parentScrollY + box->scrollY;
-  
-  for (auto it = box->children.rbegin(); it != box->children.rend(); ++it) {
-    auto result = findScrollableElementAt(*it, px, py, childScrollX, childScrollY, scrollableChain);
-    if (result) {
-      // Add this element to chain if it's scrollable (builds chain from inner to outer)
-      if (thisIsScrollable && scrollableChain) {
-        scrollableChain->push_back(box);
-      }
-      return result;
-    }
-  }
-  
-  // If this element is scrollable, return it (and add to chain as the innermost)
-  if (thisIsScrollable) {
-    if (scrollableChain) {
-      scrollableChain->push_back(box);
-    }
-    return box;
-  }
-  
-  return nullptr;
+// True if r lies entirely outside the cull rect (touching edges count as inside).
+// Clipping can leave the cull rect inverted, with nothing visible at all.
+bool isOutsideCullRect(const skene::Rect &r, const skene::Rect &cullRect) {
+  return cullRect.width < 0 || cullRect.height < 0 ||
+         r.bottom() < cullRect.y || r.y > cullRect.bottom() ||
+         r.right() < cullRect.x || r.x > cullRect.right();
 }
 
-// Paint Logic - with off-screen culling
-void paint(skene::Renderer &renderer, std::shared_ptr<skene::RenderBox> box,
+void paintVisibleChildren(skene::Renderer &renderer, const std::shared_ptr<skene::RenderBox> &box,
+                          skene::MSDFFontManager &fontManager, skene::StyleSheet &styleSheet,
+                          const skene::Rect &cullRect);
+
+// Paint Logic - with off-screen culling. cullRect is the visible area in the
+// box's coordinate space (the viewport, narrowed and shifted by scroll containers).
+void paint(skene::Renderer &renderer, const std::shared_ptr<skene::RenderBox> &box,
            skene::MSDFFontManager &fontManager, skene::StyleSheet &styleSheet,
-           float viewportTop, float viewportBottom) {
+           const skene::Rect &cullRect) {
   if (!box->node)
     return;
 
   auto &style = box->computedStyle;
-  skene::Rect borderBox = box->box.borderBox();
+  if (style.display == skene::DisplayType::Hidden)
+    return;
 
-  // Skip if not visible (zero size)
-  if (borderBox.width <= 0 || borderBox.height <= 0) {
-    // Still paint children (they might be positioned)
-    for (auto &child : box->children) {
-      paint(renderer, child, fontManager, styleSheet, viewportTop, viewportBottom);
-    }
+  // Off-screen culling: skip the whole subtree if nothing it paints (its
+  // visual overflow, from layout) reaches the viewport
+  if (isOutsideCullRect(box->visualOverflow, cullRect))
     return;
-  }
-  
-  // Off-screen culling: skip elements completely outside viewport
-  float elementTop = borderBox.y;
-  float elementBottom = borderBox.y + borderBox.height;
-  
-  if (elementBottom < viewportTop || elementTop > viewportBottom) {
-    // Element is completely off-screen, but children might be visible (positioned elements)
-    // Only recurse if this is a container that might have absolutely positioned children
-    if (box->children.empty()) {
-      return; // Leaf node, safe to skip entirely
-    }
-    // For containers, still check children (they might be positioned differently)
-    for (auto &child : box->children) {
-      paint(renderer, child, fontManager, styleSheet, viewportTop, viewportBottom);
-    }
+
+  skene::Rect borderBox = box->box.borderBox();
+
+  // Skipped (content-visibility) or deferred content only paints its own box below
+  bool paintChildren = box->childrenLaidOut();
+
+  // Skip the box itself if not visible (zero size) or off-screen; some of its
+  // descendants overflow into the viewport
+  if (borderBox.width <= 0 || borderBox.height <= 0 || isOutsideCullRect(borderBox, cullRect)) {
+    if (paintChildren) paintVisibleChildren(renderer, box, fontManager, styleSheet, cullRect);
     return;
   }
 
@@ -1264,9 +1225,7 @@ void paint(skene::Renderer &renderer, std::shared_ptr<skene::RenderBox> box,
     std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
     if (tag == "li" && style.listStyleType != skene::ListStyleType::None) {
       // Get font for the marker
-      skene::MSDFFont* font = fontManager.getFont(style.fontFamily, 
-          static_cast<int>(style.fontWeight), static_cast<int>(style.fontStyle));
-      if (!font) font = fontManager.getDefaultFont();
+      skene::MSDFFont* font = skene::fontForStyle(&fontManager, style);
       
       if (font) {
         float fontSize = style.fontSize;
@@ -1380,9 +1339,7 @@ void paint(skene::Renderer &renderer, std::shared_ptr<skene::RenderBox> box,
         // Text/password/email inputs: render placeholder text
         auto it = box->node->attributes.find("placeholder");
         if (it != box->node->attributes.end() && !it->second.empty()) {
-          skene::MSDFFont* font = fontManager.getFont(style.fontFamily, 
-              static_cast<int>(style.fontWeight), static_cast<int>(style.fontStyle));
-          if (!font) font = fontManager.getDefaultFont();
+          skene::MSDFFont* font = skene::fontForStyle(&fontManager, style);
           
           if (font) {
             float fontSize = style.fontSize;
@@ -1484,9 +1441,7 @@ void paint(skene::Renderer &renderer, std::shared_ptr<skene::RenderBox> box,
       }
       
       if (!placeholder.empty()) {
-        skene::MSDFFont* font = fontManager.getFont(style.fontFamily, 
-            static_cast<int>(style.fontWeight), static_cast<int>(style.fontStyle));
-        if (!font) font = fontManager.getDefaultFont();
+        skene::MSDFFont* font = skene::fontForStyle(&fontManager, style);
         
         if (font) {
           float fontSize = style.fontSize;
@@ -1517,9 +1472,7 @@ void paint(skene::Renderer &renderer, std::shared_ptr<skene::RenderBox> box,
   // 5. Draw text
   if (box->node->type == skene::NodeType::Text) {
     // Get MSDF font for this element's font-family with weight and style
-    skene::MSDFFont* font = fontManager.getFont(style.fontFamily, 
-        static_cast<int>(style.fontWeight), static_cast<int>(style.fontStyle));
-    if (!font) font = fontManager.getDefaultFont();
+    skene::MSDFFont* font = skene::fontForStyle(&fontManager, style);
     
     // Use wrapped text lines if available
     if (!box->textLines.empty() && font) {
@@ -1636,10 +1589,11 @@ void paint(skene::Renderer &renderer, std::shared_ptr<skene::RenderBox> box,
     }
   }
 
-  // 5. Handle overflow clipping and scrolling
+  // 5. Handle overflow clipping and scrolling (contain: paint clips like overflow: hidden)
   bool hasClipping = style.overflow == skene::Overflow::Hidden ||
                      style.overflow == skene::Overflow::Scroll ||
-                     style.overflow == skene::Overflow::Auto;
+                     style.overflow == skene::Overflow::Auto ||
+                     style.containPaint;
   bool hasScrolling = box->isScrollable();
   
   if (hasClipping) {
@@ -1654,9 +1608,22 @@ void paint(skene::Renderer &renderer, std::shared_ptr<skene::RenderBox> box,
     renderer.pushTranslate(-box->scrollX, -box->scrollY);
   }
 
-  // 6. Paint children
-  for (auto &child : box->children) {
-    paint(renderer, child, fontManager, styleSheet, viewportTop, viewportBottom);
+  // 6. Paint children, culled against what's visible through this box's clip
+  // and scroll offset
+  if (paintChildren) {
+    skene::Rect childCullRect = cullRect;
+    if (hasClipping) {
+      const skene::Rect &clip = box->box.content;
+      float left = std::max(cullRect.x, clip.x);
+      float top = std::max(cullRect.y, clip.y);
+      childCullRect = {left, top, std::min(cullRect.right(), clip.right()) - left,
+                       std::min(cullRect.bottom(), clip.bottom()) - top};
+    }
+    if (hasScrolling) {
+      childCullRect.x += box->scrollX;
+      childCullRect.y += box->scrollY;
+    }
+    paintVisibleChildren(renderer, box, fontManager, styleSheet, childCullRect);
   }
   
   // Pop scroll translation
@@ -1715,34 +1682,96 @@ void paint(skene::Renderer &renderer, std::shared_ptr<skene::RenderBox> box,
   renderer.setOpacity(1.0f);
 }
 
-// Helper: Calculate the maximum width extent of all content (for horizontal scrolling)
-float calculateMaxContentWidth(const std::shared_ptr<skene::RenderBox>& box, bool isRoot = true) {
-  if (!box) return 0.0f;
-  
-  float maxWidth = box->box.borderBox().right();
-  
-  // If this box has overflow handling (scroll/auto/hidden), don't count its children's widths
-  // towards the page's max width - they handle their own scrolling
-  bool hasOwnScrolling = !isRoot && (
-    box->computedStyle.overflow == skene::Overflow::Scroll ||
-    box->computedStyle.overflow == skene::Overflow::Auto ||
-    box->computedStyle.overflow == skene::Overflow::Hidden
-  );
-  
-  if (!hasOwnScrolling) {
-    // Check all children
-    for (const auto& child : box->children) {
-      float childMax = calculateMaxContentWidth(child, false);
-      maxWidth = std::max(maxWidth, childMax);
-    }
+// Paint the children of box that reach the cull rect. Where their overflow
+// rects run top to bottom, binary search for the first one that reaches it
+// and stop after the last, so long pages cost what's visible, not their length.
+void paintVisibleChildren(skene::Renderer &renderer, const std::shared_ptr<skene::RenderBox> &box,
+                          skene::MSDFFontManager &fontManager, skene::StyleSheet &styleSheet,
+                          const skene::Rect &cullRect) {
+  auto &children = box->children;
+  auto it = children.begin();
+  if (box->childOverflowSorted) {
+    it = std::partition_point(children.begin(), children.end(), [&](const auto &child) {
+      return child->visualOverflow.bottom() < cullRect.y;
+    });
+  }
+  for (; it != children.end(); ++it) {
+    if (box->childOverflowSorted && (*it)->visualOverflow.y > cullRect.bottom()) break;
+    if ((*it)->isPaintLayer()) continue;  // Painted in stacking order (paintStackingContext)
+    paint(renderer, *it, fontManager, styleSheet, cullRect);
+  }
+}
+
+// Paint a layer's box and its normal flow at the layer's offset for the
+// current scroll, inside its clip. Call with the page scroll translation
+// applied; viewport is the visible area in page coordinates.
+void paintLayerBox(skene::Renderer &renderer, const skene::RenderTree::PaintLayer &layer,
+                   skene::MSDFFontManager &fontManager, skene::StyleSheet &styleSheet,
+                   const skene::Rect &viewport) {
+  skene::Rect cullRect = viewport;
+  if (layer.clipped) {
+    float left = std::max(cullRect.x, layer.clip.x);
+    float top = std::max(cullRect.y, layer.clip.y);
+    cullRect = {left, top, std::min(cullRect.right(), layer.clip.right()) - left,
+                std::min(cullRect.bottom(), layer.clip.bottom()) - top};
+    if (cullRect.width <= 0 || cullRect.height <= 0) return;
+    renderer.flushRects();
+    renderer.setClipRect(layer.clip.x, layer.clip.y, layer.clip.width, layer.clip.height);
+  }
+  cullRect.x -= layer.offsetX;
+  cullRect.y -= layer.offsetY;
+  renderer.pushTranslate(layer.offsetX, layer.offsetY);
+  paint(renderer, layer.box->shared_from_this(), fontManager, styleSheet, cullRect);
+  renderer.popTranslate(layer.offsetX, layer.offsetY);
+  if (layer.clipped) {
+    renderer.flushRects();
+    renderer.clearClipRect();
   }
-  
-  return maxWidth;
+}
+
+// Paint a stacking context from its prepared z-order lists: negative z-index
+// contexts, its own box and normal flow, positioned and translucent layers,
+// then positive z-index contexts. The root context is painted in place.
+void paintStackingContext(skene::Renderer &renderer,
+                          const std::vector<skene::RenderTree::StackingContext> &contexts,
+                          size_t index, const std::vector<skene::RenderTree::PaintLayer> &layers,
+                          skene::MSDFFontManager &fontManager, skene::StyleSheet &styleSheet,
+                          const skene::Rect &viewport) {
+  const auto &context = contexts[index];
+  auto paintLayer = [&](skene::RenderBox *box) {
+    if (box->stackingContextIndex >= 0) {
+      paintStackingContext(renderer, contexts, box->stackingContextIndex, layers, fontManager,
+                           styleSheet, viewport);
+    } else if (layers[box->paintLayerIndex].box == box) {
+      paintLayerBox(renderer, layers[box->paintLayerIndex], fontManager, styleSheet, viewport);
+    }
+  };
+  for (skene::RenderBox *box : context.negativeZ) paintLayer(box);
+  if (index == 0) {
+    paint(renderer, context.box->shared_from_this(), fontManager, styleSheet, viewport);
+  } else if (layers[context.box->paintLayerIndex].box == context.box) {
+    paintLayerBox(renderer, layers[context.box->paintLayerIndex], fontManager, styleSheet,
+                  viewport);
+  }
+  for (skene::RenderBox *box : context.positioned) paintLayer(box);
+  for (skene::RenderBox *box : context.positiveZ) paintLayer(box);
+}
+
+// Paint the page in stacking order. Call with the page scroll translation
+// applied; viewport is the visible area in page coordinates.
+void paintPage(skene::Renderer &renderer, skene::RenderTree &renderTree,
+               skene::MSDFFontManager &fontManager, skene::StyleSheet &styleSheet,
+               const skene::Rect &viewport) {
+  const auto &contexts = renderTree.stackingContexts();
+  if (contexts.empty()) return;
+  const auto &layers = renderTree.paintLayers(scrollX, scrollY);
+  paintStackingContext(renderer, contexts, 0, layers, fontManager, styleSheet, viewport);
 }
 
 // Reload function for Ctrl+R
 void reloadPage() {
   if (!g_renderTree || !g_styleSheet || !g_fontManager || !g_dom) return;
+  if (g_layoutWorker) g_layoutWorker->cancel();  // It reads the DOM being replaced
   
   // Save current scroll position before reloading
   float savedScrollX = scrollX;
@@ -1788,7 +1817,7 @@ void reloadPage() {
                               *g_styleSheet, g_fontManager);
   
   // Reset text selection
-  textSelection.allTextBoxes.clear();
+  textSelection.setTextBoxes({}, 0);
   textSelection.hasSelection = false;
   selectedNode = nullptr;
   
@@ -1827,10 +1856,9 @@ void doRenderFast() {
   // Apply scroll offset
   renderer.pushTranslate(-scrollX, -scrollY);
   
-  float viewportTop = scrollY;
-  float viewportBottom = scrollY + screenHeight;
+  skene::Rect viewport{scrollX, scrollY, (float)(screenWidth - INSPECTOR_WIDTH), (float)screenHeight};
   
-  paint(renderer, renderTree.root, fontManager, styleSheet, viewportTop, viewportBottom);
+  paintPage(renderer, renderTree, fontManager, styleSheet, viewport);
   renderer.popTranslate(-scrollX, -scrollY);
 
   glDisable(GL_SCISSOR_TEST);
@@ -1854,7 +1882,8 @@ void doRenderFast() {
   SDL_GL_SwapWindow(g_window);
 }
 
-// Render function that can be called during resize
+// Render the current tree; called during resize, while the layout worker lays
+// out for the new size
 void doRender() {
   if (!g_renderer || !g_renderTree || !g_styleSheet || !g_fontManager || !g_window) return;
   
@@ -1863,25 +1892,21 @@ void doRender() {
   auto& styleSheet = *g_styleSheet;
   auto& fontManager = *g_fontManager;
   
-  // Re-layout with new size, passing current scroll position for off-screen optimization
-  renderTree.relayout((float)(screenWidth - INSPECTOR_WIDTH), (float)screenHeight,
-                      styleSheet, &fontManager, scrollY);
-  g_needsLayout = false;  // We just did layout
+  adoptLayoutSnapshot(renderTree);
 
   // Calculate max scroll based on content height and width
   if (renderTree.root) {
     float contentHeight = renderTree.root->box.borderBox().height;
     // Use maximum width extent of all content (including children that overflow)
-    float maxContentWidth = calculateMaxContentWidth(renderTree.root);
+    float maxContentWidth = renderTree.root->scrollableOverflow.right();
     maxScrollY = std::max(0.0f, contentHeight - (float)screenHeight);
     maxScrollX = std::max(0.0f, maxContentWidth - (float)(screenWidth - INSPECTOR_WIDTH));
     if (scrollY > maxScrollY) scrollY = maxScrollY;
     if (scrollX > maxScrollX) scrollX = maxScrollX;
   }
 
-  // Rebuild text boxes list
-  textSelection.allTextBoxes.clear();
-  collectTextBoxes(renderTree.root, textSelection.allTextBoxes, false);
+  // Refresh text boxes list
+  updateTextBoxes(renderTree);
 
   renderer.clear();
 
@@ -1893,15 +1918,15 @@ void doRender() {
   renderer.pushTranslate(-scrollX, -scrollY);
   
   // Calculate viewport bounds in content space (accounting for scroll)
-  float viewportTop = scrollY;
-  float viewportBottom = scrollY + screenHeight;
-  float viewportLeft = scrollX;
-  float viewportRight = scrollX + (screenWidth - INSPECTOR_WIDTH);
+  skene::Rect viewport{scrollX, scrollY, (float)(screenWidth - INSPECTOR_WIDTH), (float)screenHeight};
   
   // Draw selection highlights first (fills gaps between inline elements)
-  paintSelectionHighlights(renderer, fontManager);
+  paintSelectionHighlights(renderer, renderTree, fontManager, viewport);
   
-  paint(renderer, renderTree.root, fontManager, styleSheet, viewportTop, viewportBottom);
+  auto paintStart = std::chrono::steady_clock::now();
+  paintPage(renderer, renderTree, fontManager, styleSheet, viewport);
+  paintWalkMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() -
+                                                         paintStart).count();
   renderer.popTranslate(-scrollX, -scrollY);
 
   glDisable(GL_SCISSOR_TEST);
@@ -1968,7 +1993,10 @@ int resizeEventWatcher(void* data, SDL_Event* event) {
       if (g_renderer) {
         g_renderer->resize(screenWidth, screenHeight);
       }
-      doRender();  // Full render with relayout
+      // Lay out for the new size in the background and keep painting the
+      // previous layout meanwhile
+      requestLayoutSnapshot();
+      doRender();
     }
   }
   return 0;
@@ -2033,6 +2061,7 @@ int main(int argc, char *argv[]) {
 
   skene::RenderTree renderTree;
   skene::StyleSheet styleSheet;
+  skene::LayoutWorker layoutWorker(&fontManager);
 
   // Load user agent stylesheet (browser defaults)
   std::ifstream uaFile("src/style/userAgent.css");
@@ -2061,6 +2090,7 @@ int main(int argc, char *argv[]) {
   g_renderTree = &renderTree;
   g_styleSheet = &styleSheet;
   g_fontManager = &fontManager;
+  g_layoutWorker = &layoutWorker;
   g_dom = dom;
   
   // Add event watcher for real-time resize rendering
@@ -2096,8 +2126,9 @@ int main(int argc, char *argv[]) {
           screenWidth = e.window.data1;
           screenHeight = e.window.data2;
           renderer.resize(screenWidth, screenHeight);
-          // Trigger relayout for new size (scroll will be clamped in layout code)
-          g_needsLayout = true;
+          // Relayout for the new size on the layout worker (scroll is clamped
+          // once it's adopted)
+          requestLayoutSnapshot();
         }
       } else if (e.type == SDL_MOUSEBUTTONDOWN) {
         int mx = e.button.x;
@@ -2173,7 +2204,7 @@ int main(int argc, char *argv[]) {
           float contentY = (float)my + scrollY;  // Adjust for scroll
           
           // Check if clicking on a link first
-          auto clickedBox = findBoxAtPoint(renderTree.root, contentX, (float)my, scrollY);
+          auto clickedBox = renderTree.findBoxAtPoint(contentX, (float)my, scrollY, scrollX);
           if (clickedBox) {
             std::string href = findLinkHref(clickedBox->node);
             if (!href.empty() && href != "#" && clickCount == 1) {
@@ -2190,7 +2221,7 @@ int main(int argc, char *argv[]) {
           }
           
           size_t lineIdx = 0, charIdx = 0;
-          auto textBox = findTextBoxAt(renderTree.root, contentX, contentY, fontManager, lineIdx, charIdx, true);
+          auto textBox = findTextBoxAt(contentX, contentY, fontManager, lineIdx, charIdx, true);
           
           // Check for Shift+Click to extend selection
           bool shiftHeld = (SDL_GetModState() & KMOD_SHIFT) != 0;
@@ -2228,7 +2259,7 @@ int main(int argc, char *argv[]) {
               } else if (clickCount >= 3) {
                 // Triple-click or more: select entire block element (paragraph, etc.)
                 // This matches Chrome behavior where triple-click selects the whole paragraph
-                auto [firstBox, lastBox] = findBlockTextBoxRange(textBox, textSelection.allTextBoxes);
+                auto [firstBox, lastBox] = findBlockTextBoxRange(textBox, textSelection);
                 
                 textSelection.anchorBox = firstBox;
                 textSelection.focusBox = lastBox;
@@ -2315,9 +2346,9 @@ int main(int argc, char *argv[]) {
                 isAfterAnchor = (charIdx >= anchorWordEnd);
               } else {
                 // Compare box positions in document order
-                auto it1 = std::find(textSelection.allTextBoxes.begin(), textSelection.allTextBoxes.end(), textSelection.anchorBox);
-                auto it2 = std::find(textSelection.allTextBoxes.begin(), textSelection.allTextBoxes.end(), textBox);
-                isAfterAnchor = (it2 > it1) || (it2 == it1 && lineIdx > textSelection.anchorLineIndex);
+                int anchorIdx = textSelection.getBoxIndex(textSelection.anchorBox);
+                int boxIdx = textSelection.getBoxIndex(textBox);
+                isAfterAnchor = (boxIdx > anchorIdx) || (boxIdx == anchorIdx && lineIdx > textSelection.anchorLineIndex);
               }
               
               if (isAfterAnchor) {
@@ -2340,9 +2371,9 @@ int main(int argc, char *argv[]) {
               textSelection.focusLineIndex = lineIdx;
               
               // Determine direction
-              auto it1 = std::find(textSelection.allTextBoxes.begin(), textSelection.allTextBoxes.end(), textSelection.anchorBox);
-              auto it2 = std::find(textSelection.allTextBoxes.begin(), textSelection.allTextBoxes.end(), textBox);
-              bool isAfterAnchor = (it2 > it1) || (it2 == it1 && lineIdx > textSelection.anchorLineIndex);
+              int anchorIdx = textSelection.getBoxIndex(textSelection.anchorBox);
+              int boxIdx = textSelection.getBoxIndex(textBox);
+              bool isAfterAnchor = (boxIdx > anchorIdx) || (boxIdx == anchorIdx && lineIdx > textSelection.anchorLineIndex);
               
               if (isAfterAnchor) {
                 textSelection.anchorCharIndex = 0;
@@ -2367,7 +2398,7 @@ int main(int argc, char *argv[]) {
           float contentY = (float)my + scrollY;  // Adjust for scroll
           
           // First check if hovering over a link
-          auto hoverBox = findBoxAtPoint(renderTree.root, (float)mx, (float)my, scrollY);
+          auto hoverBox = renderTree.findBoxAtPoint((float)mx, (float)my, scrollY, scrollX);
           bool isOverLink = hoverBox && isInsideLink(hoverBox);
           
           SDL_Cursor* desiredCursor;
@@ -2376,7 +2407,7 @@ int main(int argc, char *argv[]) {
           } else {
             // Check if over text
             size_t dummyLine = 0, dummyChar = 0;
-            auto textHoverBox = findTextBoxAtExact(renderTree.root, (float)mx, contentY, fontManager, dummyLine, dummyChar);
+            auto textHoverBox = findTextBoxAtExact((float)mx, contentY, fontManager, dummyLine, dummyChar);
             desiredCursor = textHoverBox ? ibeamCursor : arrowCursor;
           }
           
@@ -2403,12 +2434,10 @@ int main(int argc, char *argv[]) {
         SDL_GetMouseState(&mx, &my);
         if (mx < (screenWidth - INSPECTOR_WIDTH)) {
           // Check if hovering over a scrollable element
-          float contentX = (float)mx + scrollX;
-          float contentY = (float)my + scrollY;  // Account for page scroll
-          
           // Get the scrollable element chain (innermost first, then ancestors)
           std::vector<std::shared_ptr<skene::RenderBox>> scrollableChain;
-          auto scrollableBox = findScrollableElementAt(g_renderTree->root, contentX, contentY, 0, 0, &scrollableChain);
+          auto scrollableBox = g_renderTree->findScrollableBoxAt((float)mx, (float)my, scrollY, scrollX,
+                                                                 &scrollableChain);
           
           // Check if Shift is pressed for horizontal scrolling
           bool isHorizontalScroll = shiftKeyPressed;
@@ -2423,8 +2452,7 @@ int main(int argc, char *argv[]) {
               auto& box = scrollableChain[i];
               if (box->scrollableWidth > 0) {
                 float oldScrollX = box->scrollX;
-                box->scrollX -= scrollDelta;
-                box->clampScroll();
+                box->scrollTo(box->scrollX - scrollDelta, box->scrollY);
                 float actualScroll = oldScrollX - box->scrollX;
                 if (std::abs(actualScroll - scrollDelta) < 0.01f) {
                   scrollConsumed = true;
@@ -2439,7 +2467,9 @@ int main(int argc, char *argv[]) {
               scrollX -= scrollDelta;
               if (scrollX < 0) scrollX = 0;
               if (scrollX > maxScrollX) scrollX = maxScrollX;
-              g_needsLayout = true;  // Trigger relayout for elements scrolling into view
+              // Fixed and sticky boxes follow at composite time; relayout only
+              // for content waiting to scroll into view
+              if (renderTree.layoutDependsOnScroll()) g_needsLayout = true;
             }
           } else {
             // Vertical scrolling (original behavior)
@@ -2452,8 +2482,7 @@ int main(int argc, char *argv[]) {
               float oldScrollY = box->scrollY;
               
               // Apply scroll delta
-              box->scrollY -= scrollDelta;
-              box->clampScroll();
+              box->scrollTo(box->scrollX, box->scrollY - scrollDelta);
               
               // Calculate how much was actually scrolled
               float actualScroll = oldScrollY - box->scrollY;
@@ -2472,13 +2501,18 @@ int main(int argc, char *argv[]) {
               scrollY -= scrollDelta;
               if (scrollY < 0) scrollY = 0;
               if (scrollY > maxScrollY) scrollY = maxScrollY;
-              g_needsLayout = true;  // Trigger relayout for elements scrolling into view
+              // Fixed and sticky boxes follow at composite time; relayout only
+              // for content waiting to scroll into view
+              if (renderTree.layoutDependsOnScroll()) g_needsLayout = true;
             }
           }
         }
       } else if (e.type == SDL_TEXTINPUT) {
         if (selectedNode && selectedNode->type == skene::NodeType::Element) {
+          layoutWorker.cancel();  // It may be reading the DOM
           selectedNode->attributes["style"] += e.text.text;
+          renderTree.markStyleChanged(renderTree.findBox(selectedNode));
+          g_needsLayout = true;
         }
       } else if (e.type == SDL_KEYDOWN) {
         // Track Shift key state
@@ -2490,9 +2524,12 @@ int main(int argc, char *argv[]) {
           reloadPage();
         }
         if (e.key.keysym.sym == SDLK_BACKSPACE && selectedNode) {
+          layoutWorker.cancel();  // It may be reading the DOM
           std::string &style = selectedNode->attributes["style"];
           if (!style.empty()) {
             style.pop_back();
+            renderTree.markStyleChanged(renderTree.findBox(selectedNode));
+            g_needsLayout = true;
           }
         }
         // Ctrl+C to copy selection
@@ -2565,13 +2602,7 @@ int main(int argc, char *argv[]) {
                   textSelection.focusCharIndex++;
                 } else {
                   // At end of current box, move to next text box
-                  int currentIdx = -1;
-                  for (int i = 0; i < (int)textSelection.allTextBoxes.size(); ++i) {
-                    if (textSelection.allTextBoxes[i] == textSelection.focusBox) {
-                      currentIdx = i;
-                      break;
-                    }
-                  }
+                  int currentIdx = textSelection.getBoxIndex(textSelection.focusBox);
                   if (currentIdx >= 0 && currentIdx + 1 < (int)textSelection.allTextBoxes.size()) {
                     textSelection.focusBox = textSelection.allTextBoxes[currentIdx + 1];
                     textSelection.focusLineIndex = 0;
@@ -2608,13 +2639,7 @@ int main(int argc, char *argv[]) {
                   textSelection.focusCharIndex--;
                 } else {
                   // At start of current box, move to previous text box
-                  int currentIdx = -1;
-                  for (int i = 0; i < (int)textSelection.allTextBoxes.size(); ++i) {
-                    if (textSelection.allTextBoxes[i] == textSelection.focusBox) {
-                      currentIdx = i;
-                      break;
-                    }
-                  }
+                  int currentIdx = textSelection.getBoxIndex(textSelection.focusBox);
                   if (currentIdx > 0) {
                     textSelection.focusBox = textSelection.allTextBoxes[currentIdx - 1];
                     textSelection.focusLineIndex = 0;
@@ -2802,16 +2827,18 @@ int main(int argc, char *argv[]) {
       }
     }
 
-    // Only relayout when needed (content changes, not every frame)
-    if (g_needsLayout) {
+    // Only relayout when needed (content changes, not every frame). While the
+    // layout worker has a new tree coming, keep painting the current one.
+    adoptLayoutSnapshot(renderTree);
+    if (g_needsLayout && !layoutWorker.busy()) {
       renderTree.relayout((float)(screenWidth - INSPECTOR_WIDTH), (float)screenHeight,
-                          styleSheet, &fontManager, scrollY);
-      g_needsLayout = false;
+                          styleSheet, &fontManager, scrollY, LAYOUT_SLICE_MS);
+      // Keep laying out deferred and content-visibility:auto content, a slice per frame
+      g_needsLayout = renderTree.hasPendingLayout();
 
-      // Rebuild text boxes list for selection (must be done after layout)
-      textSelection.allTextBoxes.clear();
+      // Refresh text boxes list for selection (must be done after layout)
       static bool debugOnce = true;
-      collectTextBoxes(renderTree.root, textSelection.allTextBoxes, debugOnce);
+      updateTextBoxes(renderTree, debugOnce);
       if (debugOnce) {
         std::cout << "Total text boxes collected: " << textSelection.allTextBoxes.size() << std::endl;
         debugOnce = false;
@@ -2821,7 +2848,7 @@ int main(int argc, char *argv[]) {
     // Calculate max scroll based on content height
     if (renderTree.root) {
       float contentHeight = renderTree.root->box.borderBox().height;
-      float maxContentWidth = calculateMaxContentWidth(renderTree.root);
+      float maxContentWidth = renderTree.root->scrollableOverflow.right();
       maxScrollY = std::max(0.0f, contentHeight - (float)screenHeight);
       maxScrollX = std::max(0.0f, maxContentWidth - (float)(screenWidth - INSPECTOR_WIDTH));
       // Clamp scroll if content shrunk
@@ -2839,13 +2866,14 @@ int main(int argc, char *argv[]) {
     renderer.pushTranslate(-scrollX, -scrollY);
 
     // Calculate viewport bounds in content space (accounting for scroll)
-    float viewportTop = scrollY;
-    float viewportBottom = scrollY + screenHeight;
-    float viewportLeft = scrollX;
-    float viewportRight = scrollX + (screenWidth - INSPECTOR_WIDTH);
+    skene::Rect viewport{scrollX, scrollY, (float)(screenWidth - INSPECTOR_WIDTH),
+                         (float)screenHeight};
 
     // Paint content with scroll and culling
-    paint(renderer, renderTree.root, fontManager, styleSheet, viewportTop, viewportBottom);
+    auto paintStart = std::chrono::steady_clock::now();
+    paintPage(renderer, renderTree, fontManager, styleSheet, viewport);
+    paintWalkMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() -
+                                                           paintStart).count();
 
     // Remove scroll offset
     renderer.popTranslate(-scrollX, -scrollY);
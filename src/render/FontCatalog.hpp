@@ -0,0 +1,360 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "MSDFCache.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace skene {
+
+// Font weight and style enums (matching Font.hpp)
+enum class MSDFFontWeight { Normal, Bold, Lighter, Bolder };
+enum class MSDFFontStyle { Normal, Italic, Oblique };
+
+// Structure to hold discovered system font info
+struct SystemFontInfo {
+  std::string path;
+  std::string familyName;
+  MSDFFontWeight weight;
+  MSDFFontStyle style;
+};
+
+// Modification time (nanoseconds) and size of a file, false if it can't be read
+inline bool getFileStamp(const std::string &path, int64_t &modified, uint64_t &size) {
+  std::error_code error;
+  auto time = std::filesystem::last_write_time(path, error);
+  if (error) return false;
+  size = std::filesystem::is_directory(path, error) ? 0 : std::filesystem::file_size(path, error);
+  if (error) return false;
+  modified = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+  return true;
+}
+
+// The fonts found on disk, kept across runs in one file so that startup
+// doesn't walk the font directories or stat every font and cache file.
+//
+// Directories are listed with their mtime: while it's unchanged, no files were
+// added, removed or renamed in them, and what they held last time still
+// stands. A font file changed in place is caught when it's loaded, by
+// comparing its mtime and size with the catalog's (see isCurrent).
+//
+// The cached flags hold for the MSDF cache version the catalog was written
+// with (it's in the header); under another one, every font is taken as not
+// cached until its cache is written again.
+class FontCatalog {
+public:
+  struct Font {
+    SystemFontInfo info;
+    int64_t modified = 0;  // Font file mtime, nanoseconds
+    uint64_t size = 0;
+    bool cached = false;   // It has an MSDF cache file
+  };
+
+  explicit FontCatalog(std::string file) : file(std::move(file)) {}
+
+  // Read the catalog; a missing or unreadable one leaves it empty
+  void load() {
+    std::ifstream in(file, std::ios::binary);
+    std::string line;
+    std::string format = std::string(HEADER) + " msdf ";
+    if (!in || !std::getline(in, line) || line.compare(0, format.size(), format) != 0) return;
+    bool cacheVersionChanged = line != header();
+    std::lock_guard<std::mutex> lock(mutex);
+    Directory *directory = nullptr;
+    try {
+      while (std::getline(in, line)) {
+        std::vector<std::string> fields = split(line);
+        if (fields.size() == 3 && fields[0] == "D") {
+          directory = &directories[fields[2]];
+          directory->modified = std::stoll(fields[1]);
+        } else if (fields.size() == 2 && fields[0] == "S" && directory) {
+          directory->subdirectories.push_back(fields[1]);
+        } else if (fields.size() == 8 && fields[0] == "F") {
+          Font font;
+          font.modified = std::stoll(fields[1]);
+          font.size = std::stoull(fields[2]);
+          font.info.weight = static_cast<MSDFFontWeight>(std::stoi(fields[3]));
+          font.info.style = static_cast<MSDFFontStyle>(std::stoi(fields[4]));
+          font.cached = fields[5] == "1" && !cacheVersionChanged;
+          font.info.familyName = fields[6];
+          font.info.path = fields[7];
+          fonts[font.info.path] = font;
+        }
+      }
+    } catch (const std::exception &) {
+      // A damaged catalog is rebuilt by scanning
+      directories.clear();
+      fonts.clear();
+      return;
+    }
+    for (const auto &[path, font] : fonts) {
+      auto it = directories.find(std::filesystem::path(path).parent_path().string());
+      if (it != directories.end()) it->second.fonts.push_back(path);
+    }
+    dirty = cacheVersionChanged;
+  }
+
+  // Write the catalog if it changed since it was loaded or last saved
+  void save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!dirty) return;
+    std::ostringstream out;
+    out << header() << '\n';
+    for (const auto &[path, directory] : directories) {
+      out << "D\t" << directory.modified << '\t' << path << '\n';
+      for (const auto &subdirectory : directory.subdirectories) out << "S\t" << subdirectory << '\n';
+    }
+    for (const auto &[path, font] : fonts) {
+      out << "F\t" << font.modified << '\t' << font.size << '\t' << static_cast<int>(font.info.weight)
+          << '\t' << static_cast<int>(font.info.style) << '\t' << (font.cached ? 1 : 0) << '\t'
+          << font.info.familyName << '\t' << path << '\n';
+    }
+    std::string temp = file + ".tmp";
+    {
+      std::ofstream stream(temp, std::ios::binary);
+      stream << out.str();
+      if (!stream) return;
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, file, error);
+    if (!error) dirty = false;
+  }
+
+  // The font files and subdirectories dir held when it was last scanned, if
+  // its mtime is still modified
+  bool listDirectory(const std::string &dir, int64_t modified, std::vector<std::string> &dirFonts,
+                     std::vector<std::string> &subdirectories) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = directories.find(dir);
+    if (it == directories.end() || it->second.modified != modified) return false;
+    dirFonts = it->second.fonts;
+    subdirectories = it->second.subdirectories;
+    return true;
+  }
+
+  // Record a scan of dir; fonts it no longer holds are dropped. Mtimes tick
+  // coarsely, so a directory modified in the last couple of seconds could
+  // change again without its mtime moving: it's recorded to be read again.
+  void setDirectory(const std::string &dir, int64_t modified, const std::vector<std::string> &dirFonts,
+                    const std::vector<std::string> &subdirectories) {
+    auto now = std::filesystem::file_time_type::clock::now().time_since_epoch();
+    int64_t settled = std::chrono::duration_cast<std::chrono::nanoseconds>(now - std::chrono::seconds(2)).count();
+    if (modified > settled) modified = 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    Directory &directory = directories[dir];
+    std::set<std::string> kept(dirFonts.begin(), dirFonts.end());
+    for (const auto &path : directory.fonts) {
+      if (!kept.count(path)) fonts.erase(path);
+    }
+    directory = Directory{modified, dirFonts, subdirectories};
+    dirty = true;
+  }
+
+  // Forget dir, its subdirectories and their fonts
+  void removeDirectory(const std::string &dir) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> pending{dir};
+    while (!pending.empty()) {
+      auto it = directories.find(pending.back());
+      pending.pop_back();
+      if (it == directories.end()) continue;
+      for (const auto &path : it->second.fonts) fonts.erase(path);
+      pending.insert(pending.end(), it->second.subdirectories.begin(), it->second.subdirectories.end());
+      directories.erase(it);
+      dirty = true;
+    }
+  }
+
+  bool find(const std::string &path, Font &font) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = fonts.find(path);
+    if (it == fonts.end()) return false;
+    font = it->second;
+    return true;
+  }
+
+  void put(const Font &font) {
+    std::lock_guard<std::mutex> lock(mutex);
+    fonts[font.info.path] = font;
+    dirty = true;
+  }
+
+  // Whether path has an MSDF cache file. Only fonts the catalog doesn't know
+  // are checked on disk, with exists(), and the answer is remembered.
+  template <typename Exists>
+  bool isCached(const std::string &path, Exists &&exists) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = fonts.find(path);
+      if (it != fonts.end()) return it->second.cached;
+    }
+    Font font;
+    font.info = SystemFontInfo{path, "", MSDFFontWeight::Normal, MSDFFontStyle::Normal};
+    getFileStamp(path, font.modified, font.size);
+    font.cached = exists();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [it, added] = fonts.emplace(path, font);
+    dirty = dirty || added;
+    return it->second.cached;
+  }
+
+  void setCached(const std::string &path, bool cached) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = fonts.find(path);
+    if (it == fonts.end() || it->second.cached == cached) return;
+    it->second.cached = cached;
+    dirty = true;
+  }
+
+  // Whether the font file is as the catalog has it - checked before a cache
+  // made from it is trusted. A changed file is updated in the catalog, as not
+  // cached.
+  bool isCurrent(const std::string &path) {
+    int64_t modified = 0;
+    uint64_t size = 0;
+    if (!getFileStamp(path, modified, size)) return true;  // Loading it will fail anyway
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = fonts.find(path);
+    if (it == fonts.end()) return true;
+    if (it->second.modified == modified && it->second.size == size) return true;
+    it->second.modified = modified;
+    it->second.size = size;
+    it->second.cached = false;
+    dirty = true;
+    return false;
+  }
+
+  std::vector<std::string> directoryPaths() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> paths;
+    for (const auto &entry : directories) paths.push_back(entry.first);
+    return paths;
+  }
+
+private:
+  static constexpr const char *HEADER = "skene-font-catalog 2";
+
+  // The header line: format, then the MSDF cache version the cached flags are for
+  static std::string header() {
+    return std::string(HEADER) + " msdf " + std::to_string(MSDF_CACHE_VERSION);
+  }
+
+  struct Directory {
+    int64_t modified = 0;
+    std::vector<std::string> fonts;
+    std::vector<std::string> subdirectories;
+  };
+
+  static std::vector<std::string> split(const std::string &line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    // The path is last, and taken whole
+    while (fields.size() < 7) {
+      size_t tab = line.find('\t', start);
+      if (tab == std::string::npos) break;
+      fields.push_back(line.substr(start, tab - start));
+      start = tab + 1;
+    }
+    fields.push_back(line.substr(start));
+    return fields;
+  }
+
+  std::string file;
+  mutable std::mutex mutex;
+  std::map<std::string, Directory> directories;
+  std::map<std::string, Font> fonts;
+  bool dirty = false;
+};
+
+// Reports changes in font directories - files added, removed or rewritten -
+// without rescanning them. Uses inotify; elsewhere available() is false and
+// callers poll instead.
+class FontDirectoryWatcher {
+public:
+  FontDirectoryWatcher() {
+#ifdef __linux__
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+  }
+
+  ~FontDirectoryWatcher() {
+#ifdef __linux__
+    if (fd >= 0) close(fd);
+#endif
+  }
+
+  FontDirectoryWatcher(const FontDirectoryWatcher &) = delete;
+  FontDirectoryWatcher &operator=(const FontDirectoryWatcher &) = delete;
+
+  bool available() const { return fd >= 0; }
+
+  // Watch dir (not its subdirectories, which are watched on their own)
+  void watch(const std::string &dir) {
+#ifdef __linux__
+    if (fd < 0 || watchedPaths.count(dir)) return;
+    int wd = inotify_add_watch(fd, dir.c_str(),
+                               IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM | IN_CLOSE_WRITE |
+                                   IN_DELETE_SELF | IN_ONLYDIR);
+    if (wd < 0) return;
+    watched[wd] = dir;
+    watchedPaths.insert(dir);
+#else
+    (void)dir;
+#endif
+  }
+
+  // Wait up to timeoutMs for changes; returns the directories that changed.
+  // If the kernel's event queue overflowed, events were lost, so every watched
+  // directory is returned to be rescanned.
+  std::set<std::string> wait(int timeoutMs) {
+    std::set<std::string> changed;
+#ifdef __linux__
+    if (fd < 0) return changed;
+    pollfd request{fd, POLLIN, 0};
+    if (poll(&request, 1, timeoutMs) <= 0) return changed;
+    alignas(inotify_event) char buffer[16 * 1024];
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+      for (char *p = buffer; p < buffer + length;) {
+        auto *event = reinterpret_cast<inotify_event *>(p);
+        if (event->mask & IN_Q_OVERFLOW) {
+          for (const auto &entry : watched) changed.insert(entry.second);
+        }
+        auto it = watched.find(event->wd);
+        if (it != watched.end()) {
+          changed.insert(it->second);
+          if (event->mask & IN_IGNORED) {
+            watchedPaths.erase(it->second);
+            watched.erase(it);
+          }
+        }
+        p += sizeof(inotify_event) + event->len;
+      }
+    }
+#else
+    (void)timeoutMs;
+#endif
+    return changed;
+  }
+
+private:
+  int fd = -1;
+  std::map<int, std::string> watched;
+  std::set<std::string> watchedPaths;
+};
+
+} // namespace skene
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace skene {
+
+// MSDF glyph data stored in atlas
+struct MSDFGlyph {
+  float u0, v0, u1, v1;  // Texture coordinates
+  float xoff, yoff;       // Offset from baseline
+  float width, height;    // Glyph size in pixels (at MSDF size)
+  float advance;          // Horizontal advance
+  bool valid = false;
+};
+
+// Decode UTF-8 codepoint from string, returns codepoint and advances index
+inline int decodeUTF8(std::string_view text, size_t &i) {
+  unsigned char c = text[i];
+  if ((c & 0x80) == 0) {
+    // ASCII (0xxxxxxx)
+    return c;
+  } else if ((c & 0xE0) == 0xC0 && i + 1 < text.length()) {
+    // 2-byte sequence (110xxxxx 10xxxxxx)
+    int cp = (c & 0x1F) << 6;
+    cp |= (text[++i] & 0x3F);
+    return cp;
+  } else if ((c & 0xF0) == 0xE0 && i + 2 < text.length()) {
+    // 3-byte sequence (1110xxxx 10xxxxxx 10xxxxxx)
+    int cp = (c & 0x0F) << 12;
+    cp |= (text[++i] & 0x3F) << 6;
+    cp |= (text[++i] & 0x3F);
+    return cp;
+  } else if ((c & 0xF8) == 0xF0 && i + 3 < text.length()) {
+    // 4-byte sequence (11110xxx 10xxxxxx 10xxxxxx 10xxxxxx)
+    int cp = (c & 0x07) << 18;
+    cp |= (text[++i] & 0x3F) << 12;
+    cp |= (text[++i] & 0x3F) << 6;
+    cp |= (text[++i] & 0x3F);
+    return cp;
+  }
+  return -1;  // Invalid
+}
+
+// Glyphs by codepoint, looked up once per character by text measurement and
+// drawing. Advances - all that measuring needs - are packed apart from the
+// atlas data, and are 0 for missing or invalid glyphs, so measuring a
+// character is one indexed load. Latin-1 is a page of its own; the rest of
+// Unicode goes through a page table of 256-codepoint pages made on first use.
+class GlyphTable {
+public:
+  static constexpr int PAGE_BITS = 8;
+  static constexpr int PAGE_SIZE = 1 << PAGE_BITS;
+  static constexpr int MAX_CODEPOINT = 0x10FFFF;
+
+  // Horizontal advance at the atlas glyph size (0 without a valid glyph)
+  float advance(int codepoint) const {
+    if (static_cast<unsigned>(codepoint) < PAGE_SIZE) return latin1.advances[codepoint];
+    const Page *page = findPage(codepoint);
+    return page ? page->advances[codepoint & (PAGE_SIZE - 1)] : 0.0f;
+  }
+
+  // advance(), or missing(codepoint) for a codepoint above Latin-1 the table
+  // doesn't hold at all
+  template <typename Missing>
+  float advance(int codepoint, Missing &&missing) const {
+    if (static_cast<unsigned>(codepoint) < PAGE_SIZE) return latin1.advances[codepoint];
+    const Page *page = findPage(codepoint);
+    int slot = codepoint & (PAGE_SIZE - 1);
+    return page && Page::test(page->present, slot) ? page->advances[slot] : missing(codepoint);
+  }
+
+  // Whether a glyph (valid or not) is stored for a codepoint
+  bool contains(int codepoint) const {
+    const Page *page = findPage(codepoint);
+    return page && Page::test(page->present, codepoint & (PAGE_SIZE - 1));
+  }
+
+  // The advance every printable ASCII character shares in a fixed-pitch font,
+  // or 0 if the font is proportional (or its ASCII set is incomplete)
+  float fixedAdvance() const { return fixedPitch; }
+
+  // Whether text is all printable ASCII (32-126), so that in a fixed-pitch font
+  // each byte is one character of fixedAdvance()
+  static bool isPrintableAscii(std::string_view text) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(text.data());
+    size_t length = text.size();
+    size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    // Signed compares: bytes >= 0x80 are negative, so below 32 as well
+    const __m128i low = _mm_set1_epi8(32);
+    const __m128i high = _mm_set1_epi8(126);
+    for (; i + 16 <= length; i += 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+      __m128i outside = _mm_or_si128(_mm_cmplt_epi8(chunk, low), _mm_cmpgt_epi8(chunk, high));
+      if (_mm_movemask_epi8(outside)) return false;
+    }
+#endif
+    for (; i < length; i++) {
+      if (static_cast<unsigned char>(bytes[i] - 32) >= 95) return false;
+    }
+    return true;
+  }
+
+  // Kerning-free width of UTF-8 text: the sum of advance * scale over its
+  // characters, skipping control characters and invalid bytes. ASCII spans are
+  // found 16 bytes at a time and summed straight from the Latin-1 advances;
+  // anything else is decoded one character at a time, with missing() giving
+  // the advances of codepoints the table doesn't hold.
+  template <typename Missing>
+  float measure(std::string_view text, float scale, Missing &&missing) const {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(text.data());
+    size_t length = text.size();
+    float width = 0;
+    size_t i = 0;
+    while (i < length) {
+      size_t end = asciiSpanEnd(bytes, i, length);
+      if (end > i) {
+        float span = fixedPitch > 0 ? fixedPitch * countPrintable(bytes + i, end - i)
+                                    : sumAscii(bytes + i, end - i);
+        width += span * scale;
+        i = end;
+        if (i == length) break;
+      }
+      int cp = decodeUTF8(text, i);
+      if (cp >= 32) width += advance(cp, missing) * scale;
+      i++;
+    }
+    return width;
+  }
+
+  float measure(std::string_view text, float scale) const {
+    return measure(text, scale, [](int) { return 0.0f; });
+  }
+
+  // The glyph for a codepoint, or null if it's missing or invalid
+  const MSDFGlyph *find(int codepoint) const {
+    const Page *page = findPage(codepoint);
+    if (!page) return nullptr;
+    int slot = codepoint & (PAGE_SIZE - 1);
+    return Page::test(page->valid, slot) ? &page->glyphs[slot] : nullptr;
+  }
+
+  void set(int codepoint, const MSDFGlyph &glyph) {
+    if (codepoint < 0 || codepoint > MAX_CODEPOINT) return;
+    Page &page = pageFor(codepoint);
+    int slot = codepoint & (PAGE_SIZE - 1);
+    if (!Page::test(page.present, slot)) count++;
+    Page::assign(page.present, slot, true);
+    Page::assign(page.valid, slot, glyph.valid);
+    // Control characters are skipped when measuring
+    page.advances[slot] = glyph.valid && codepoint >= 32 ? glyph.advance : 0.0f;
+    page.glyphs[slot] = glyph;
+    if (codepoint >= 32 && codepoint <= 126) updateFixedPitch();
+  }
+
+  // Glyphs stored, valid or not
+  size_t size() const { return count; }
+
+  // Visit each stored glyph as fn(codepoint, glyph), in codepoint order
+  template <typename Fn>
+  void forEach(Fn &&fn) const {
+    visitPage(latin1, 0, fn);
+    for (size_t index = 1; index < pages.size(); index++) {
+      if (pages[index]) visitPage(*pages[index], static_cast<int>(index << PAGE_BITS), fn);
+    }
+  }
+
+private:
+  struct Page {
+    std::array<float, PAGE_SIZE> advances{};
+    std::array<uint64_t, PAGE_SIZE / 64> present{};
+    std::array<uint64_t, PAGE_SIZE / 64> valid{};
+    std::array<MSDFGlyph, PAGE_SIZE> glyphs{};
+
+    static bool test(const std::array<uint64_t, PAGE_SIZE / 64> &bits, int slot) {
+      return (bits[slot >> 6] >> (slot & 63)) & 1;
+    }
+    static void assign(std::array<uint64_t, PAGE_SIZE / 64> &bits, int slot, bool on) {
+      uint64_t mask = uint64_t(1) << (slot & 63);
+      bits[slot >> 6] = on ? bits[slot >> 6] | mask : bits[slot >> 6] & ~mask;
+    }
+  };
+
+  // End of the run of ASCII bytes starting at i
+  static size_t asciiSpanEnd(const unsigned char *bytes, size_t i, size_t length) {
+#if defined(__SSE2__) || defined(_M_X64)
+    for (; i + 16 <= length; i += 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(chunk));
+      if (mask) return i + std::countr_zero(mask);
+    }
+#else
+    for (; i + 8 <= length; i += 8) {
+      uint64_t chunk;
+      std::memcpy(&chunk, bytes + i, sizeof(chunk));
+      uint64_t high = chunk & 0x8080808080808080ull;
+      if (high) return i + std::countr_zero(high) / 8;  // Little-endian
+    }
+#endif
+    while (i < length && bytes[i] < 0x80) i++;
+    return i;
+  }
+
+  // Sum of ASCII advances, in independent partial sums so the adds overlap
+  float sumAscii(const unsigned char *bytes, size_t count) const {
+    const float *advances = latin1.advances.data();
+    float sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+      sum0 += advances[bytes[k]];
+      sum1 += advances[bytes[k + 1]];
+      sum2 += advances[bytes[k + 2]];
+      sum3 += advances[bytes[k + 3]];
+    }
+    for (; k < count; k++) sum0 += advances[bytes[k]];
+    return (sum0 + sum1) + (sum2 + sum3);
+  }
+
+  // Printable ASCII bytes in an ASCII span (the rest are control characters)
+  static size_t countPrintable(const unsigned char *bytes, size_t count) {
+    size_t printable = 0;
+    for (size_t k = 0; k < count; k++) printable += bytes[k] >= 32 && bytes[k] != 127;
+    return printable;
+  }
+
+  void updateFixedPitch() {
+    float pitch = latin1.advances[32];
+    for (int c = 32; c <= 126; c++) {
+      if (!Page::test(latin1.valid, c) || latin1.advances[c] != pitch) pitch = 0;
+    }
+    fixedPitch = pitch;
+  }
+
+  template <typename Fn>
+  static void visitPage(const Page &page, int base, Fn &fn) {
+    for (int slot = 0; slot < PAGE_SIZE; slot++) {
+      if (Page::test(page.present, slot)) fn(base + slot, page.glyphs[slot]);
+    }
+  }
+
+  const Page *findPage(int codepoint) const {
+    size_t index = static_cast<unsigned>(codepoint) >> PAGE_BITS;
+    if (index == 0) return &latin1;
+    return index < pages.size() ? pages[index].get() : nullptr;
+  }
+
+  Page &pageFor(int codepoint) {
+    size_t index = static_cast<unsigned>(codepoint) >> PAGE_BITS;
+    if (index == 0) return latin1;
+    if (index >= pages.size()) pages.resize(index + 1);
+    if (!pages[index]) pages[index] = std::make_unique<Page>();
+    return *pages[index];
+  }
+
+  Page latin1;
+  std::vector<std::unique_ptr<Page>> pages;  // By codepoint >> PAGE_BITS; [0] is latin1
+  size_t count = 0;
+  float fixedPitch = 0;
+};
+
+} // namespace skene
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GlyphTable.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace skene {
+
+// Cache file magic and version
+static constexpr uint32_t MSDF_CACHE_MAGIC = 0x4D534446;  // "MSDF"
+static constexpr uint32_t MSDF_CACHE_VERSION = 5;  // Mappable: fixed header, flat glyph table, trimmed atlas
+
+// Pixel payload encodings
+enum MSDFCacheCompression : uint32_t {
+  MSDF_CACHE_RAW = 0,  // Rows of RGB, uploadable straight from the file
+  MSDF_CACHE_RLE = 1,  // Runs of RGB pixels (see encodePixelRuns)
+};
+
+// A cache file is this header, the glyph table right after it, then the
+// atlas pixels at pixelOffset. Everything is fixed-size and native-endian, so a
+// mapped file is used in place.
+struct MSDFCacheHeader {
+  uint32_t magic = MSDF_CACHE_MAGIC;
+  uint32_t version = MSDF_CACHE_VERSION;
+  uint64_t fontHash = 0;
+  int32_t atlasWidth = 0;
+  int32_t atlasHeight = 0;  // Only the rows glyphs were packed into
+  float pixelRange = 0;
+  float glyphSize = 0;
+  float ascent = 0;
+  float descent = 0;
+  float lineGap = 0;
+  uint32_t glyphCount = 0;
+  uint32_t compression = MSDF_CACHE_RAW;
+  uint32_t reserved = 0;
+  uint64_t pixelOffset = 0;
+  uint64_t pixelBytes = 0;  // As stored
+};
+static_assert(sizeof(MSDFCacheHeader) == 72, "MSDF cache header layout changed");
+
+struct MSDFCacheGlyph {
+  int32_t codepoint;
+  MSDFGlyph glyph;
+};
+
+// A read-only memory mapping of a whole file
+class MappedFile {
+public:
+  static std::unique_ptr<MappedFile> open(const std::string &path) {
+    auto file = std::unique_ptr<MappedFile>(new MappedFile());
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+      CloseHandle(handle);
+      return nullptr;
+    }
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (!mapping) return nullptr;
+    file->bytes = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (!file->bytes) return nullptr;
+    file->length = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+      ::close(fd);
+      return nullptr;
+    }
+    void *data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return nullptr;
+    file->bytes = static_cast<const unsigned char *>(data);
+    file->length = static_cast<size_t>(info.st_size);
+#endif
+    return file;
+  }
+
+  ~MappedFile() {
+    if (!bytes) return;
+#ifdef _WIN32
+    UnmapViewOfFile(bytes);
+#else
+    munmap(const_cast<unsigned char *>(bytes), length);
+#endif
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const unsigned char *data() const { return bytes; }
+  size_t size() const { return length; }
+
+private:
+  MappedFile() = default;
+
+  const unsigned char *bytes = nullptr;
+  size_t length = 0;
+};
+
+// A mapped cache file whose header has been checked against its size
+class MSDFCacheFile {
+public:
+  // The cache at path, or null if it's missing, from another version, or
+  // truncated
+  static std::unique_ptr<MSDFCacheFile> open(const std::string &path) {
+    auto mapping = MappedFile::open(path);
+    if (!mapping || mapping->size() < sizeof(MSDFCacheHeader)) return nullptr;
+    auto file = std::unique_ptr<MSDFCacheFile>(new MSDFCacheFile(std::move(mapping)));
+    const MSDFCacheHeader &header = file->header();
+    if (header.magic != MSDF_CACHE_MAGIC || header.version != MSDF_CACHE_VERSION) return nullptr;
+    if (header.atlasWidth <= 0 || header.atlasHeight <= 0) return nullptr;
+    uint64_t size = file->mapping->size();
+    uint64_t glyphsEnd = sizeof(MSDFCacheHeader) + uint64_t(header.glyphCount) * sizeof(MSDFCacheGlyph);
+    if (glyphsEnd > header.pixelOffset || header.pixelOffset > size ||
+        header.pixelBytes > size - header.pixelOffset) {
+      return nullptr;
+    }
+    if (header.compression == MSDF_CACHE_RAW && header.pixelBytes != file->pixelCount() * 3) return nullptr;
+    if (header.compression != MSDF_CACHE_RAW && header.compression != MSDF_CACHE_RLE) return nullptr;
+    return file;
+  }
+
+  const MSDFCacheHeader &header() const {
+    return *reinterpret_cast<const MSDFCacheHeader *>(mapping->data());
+  }
+
+  const MSDFCacheGlyph *glyphs() const {
+    return reinterpret_cast<const MSDFCacheGlyph *>(mapping->data() + sizeof(MSDFCacheHeader));
+  }
+
+  // The stored pixels - RGB rows for MSDF_CACHE_RAW
+  const unsigned char *pixels() const { return mapping->data() + header().pixelOffset; }
+
+  size_t pixelCount() const { return size_t(header().atlasWidth) * size_t(header().atlasHeight); }
+
+  // The atlas as RGB rows, decoding a compressed payload into out
+  bool decodePixels(std::vector<unsigned char> &out) const {
+    out.resize(pixelCount() * 3);
+    if (header().compression == MSDF_CACHE_RAW) {
+      std::memcpy(out.data(), pixels(), out.size());
+      return true;
+    }
+    return decodePixelRuns(pixels(), header().pixelBytes, out.data(), pixelCount());
+  }
+
+  // Runs of RGB pixels: a control byte under 0x80 is followed by that many
+  // plus one literal pixels, one from 0x80 up by a pixel repeated (control -
+  // 0x80 + 2) times. Atlases are mostly empty padding, so they shrink a lot.
+  static void encodePixelRuns(const unsigned char *rgb, size_t count, std::vector<unsigned char> &out) {
+    out.clear();
+    size_t i = 0;
+    while (i < count) {
+      size_t run = 1;
+      while (i + run < count && run < 129 && std::memcmp(rgb + i * 3, rgb + (i + run) * 3, 3) == 0) run++;
+      if (run >= 3) {
+        out.push_back(static_cast<unsigned char>(0x80 + run - 2));
+        out.insert(out.end(), rgb + i * 3, rgb + i * 3 + 3);
+        i += run;
+        continue;
+      }
+      // Literals up to the next run of three
+      size_t start = i;
+      while (i < count && i - start < 128) {
+        if (i + 2 < count && std::memcmp(rgb + i * 3, rgb + (i + 1) * 3, 3) == 0 &&
+            std::memcmp(rgb + i * 3, rgb + (i + 2) * 3, 3) == 0) {
+          break;
+        }
+        i++;
+      }
+      out.push_back(static_cast<unsigned char>(i - start - 1));
+      out.insert(out.end(), rgb + start * 3, rgb + i * 3);
+    }
+  }
+
+  static bool decodePixelRuns(const unsigned char *in, size_t size, unsigned char *rgb, size_t count) {
+    size_t pos = 0;
+    size_t pixel = 0;
+    while (pos < size) {
+      unsigned control = in[pos++];
+      if (control < 0x80) {
+        size_t literal = control + 1;
+        if (pixel + literal > count || pos + literal * 3 > size) return false;
+        std::memcpy(rgb + pixel * 3, in + pos, literal * 3);
+        pos += literal * 3;
+        pixel += literal;
+      } else {
+        size_t run = control - 0x80 + 2;
+        if (pixel + run > count || pos + 3 > size) return false;
+        for (size_t k = 0; k < run; k++) std::memcpy(rgb + (pixel + k) * 3, in + pos, 3);
+        pos += 3;
+        pixel += run;
+      }
+    }
+    return pixel == count;
+  }
+
+  // Write a cache file: into a temporary file renamed over path, so processes
+  // with the old file mapped keep their copy intact. The header's
+  // glyphCount, compression and offsets are filled in here; pixels are
+  // run-length encoded when that at least halves them.
+  static bool write(const std::string &path, MSDFCacheHeader header,
+                    const std::vector<MSDFCacheGlyph> &glyphs, const unsigned char *rgb) {
+    size_t count = size_t(header.atlasWidth) * size_t(header.atlasHeight);
+    std::vector<unsigned char> encoded;
+    encodePixelRuns(rgb, count, encoded);
+    bool compress = encoded.size() * 2 <= count * 3;
+
+    header.glyphCount = static_cast<uint32_t>(glyphs.size());
+    header.compression = compress ? MSDF_CACHE_RLE : MSDF_CACHE_RAW;
+    uint64_t glyphsEnd = sizeof(MSDFCacheHeader) + glyphs.size() * sizeof(MSDFCacheGlyph);
+    header.pixelOffset = (glyphsEnd + 15) & ~uint64_t(15);
+    header.pixelBytes = compress ? encoded.size() : count * 3;
+
+    std::string temp = path + ".tmp";
+    FILE *file = std::fopen(temp.c_str(), "wb");
+    if (!file) return false;
+    static const unsigned char zeros[16] = {};
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(glyphs.data(), sizeof(MSDFCacheGlyph), glyphs.size(), file) == glyphs.size() &&
+              std::fwrite(zeros, 1, header.pixelOffset - glyphsEnd, file) == header.pixelOffset - glyphsEnd &&
+              std::fwrite(compress ? encoded.data() : rgb, 1, header.pixelBytes, file) == header.pixelBytes;
+    ok = std::fclose(file) == 0 && ok;
+    std::error_code error;
+    if (ok) std::filesystem::rename(temp, path, error);
+    if (!ok || error) {
+      std::filesystem::remove(temp, error);
+      return false;
+    }
+    return true;
+  }
+
+private:
+  explicit MSDFCacheFile(std::unique_ptr<MappedFile> mapping) : mapping(std::move(mapping)) {}
+
+  std::unique_ptr<MappedFile> mapping;
+};
+
+} // namespace skene
@@ -7,6 +7,7 @@
 #include <cmath>
 #include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <functional>
@@ -18,6 +19,7 @@
 #include <set>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 // msdfgen includes
@@ -26,6 +28,11 @@
 // stb_truetype for parsing TTF files
 #include "stb/stb_truetype.h"
 
+#include "FontCatalog.hpp"
+#include "GlyphTable.hpp"
+#include "MSDFCache.hpp"
+#include "WordWidthCache.hpp"
+
 #ifdef _WIN32
 #include <windows.h>
 #include <shlobj.h>
@@ -34,10 +41,6 @@
 
 namespace skene {
 
-// Cache file magic and version
-static constexpr uint32_t MSDF_CACHE_MAGIC = 0x4D534446;  // "MSDF"
-static constexpr uint32_t MSDF_CACHE_VERSION = 4;  // Faster: smaller atlas, basic ASCII only
-
 // Get the executable's directory
 inline std::string getExecutableDirectory() {
   #ifdef _WIN32
@@ -61,10 +64,13 @@ inline std::string getExecutableDirectory() {
 
 // Get the cache directory path (relative to executable)
 inline std::string getMSDFCacheDirectory() {
-  std::string cacheDir = getExecutableDirectory() + "/cache/fonts";
-  
-  // Ensure directory exists
-  std::filesystem::create_directories(cacheDir);
+  // Ensure directory exists (once per run)
+  static const std::string cacheDir = [] {
+    std::string dir = getExecutableDirectory() + "/cache/fonts";
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    return dir;
+  }();
   return cacheDir;
 }
 
@@ -126,15 +132,6 @@ inline std::string getCacheFilename(const std::string& fontPath) {
   return baseName + "_" + std::to_string(pathHash) + ".msdf";
 }
 
-// MSDF glyph data stored in atlas
-struct MSDFGlyph {
-  float u0, v0, u1, v1;  // Texture coordinates
-  float xoff, yoff;       // Offset from baseline
-  float width, height;    // Glyph size in pixels (at MSDF size)
-  float advance;          // Horizontal advance
-  bool valid = false;
-};
-
 // MSDF font atlas - stores all glyphs in one texture
 struct MSDFAtlas {
   GLuint textureID = 0;
@@ -142,7 +139,7 @@ struct MSDFAtlas {
   int atlasHeight = 0;
   float pixelRange = 4.0f;  // Distance field range in pixels
   float glyphSize = 32.0f;  // Size glyphs were rendered at
-  std::map<int, MSDFGlyph> glyphs;  // Unicode codepoint -> glyph
+  GlyphTable glyphs;  // Unicode codepoint -> glyph
   
   // Font metrics (in em units, multiply by fontSize/glyphSize)
   float ascent = 0;
@@ -152,20 +149,31 @@ struct MSDFAtlas {
   // Raw atlas data (for caching without GPU)
   std::vector<unsigned char> rawData;
   
+  // The mapped cache file it was loaded from, until the pixels are uploaded
+  // straight from it
+  std::unique_ptr<MSDFCacheFile> cacheFile;
+  
   ~MSDFAtlas() {
     if (textureID) {
       glDeleteTextures(1, &textureID);
     }
   }
   
+  // Atlas pixels not yet uploaded, from rawData or the mapped cache file
+  const unsigned char *pixelData() const {
+    if (!rawData.empty()) return rawData.data();
+    return cacheFile ? cacheFile->pixels() : nullptr;
+  }
+  
   // Upload raw data to GPU (must be called from main thread)
   void uploadToGPU() {
-    if (textureID != 0 || rawData.empty()) return;
+    const unsigned char *pixels = pixelData();
+    if (textureID != 0 || !pixels) return;
     
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, atlasWidth, atlasHeight, 0,
-                 GL_RGB, GL_UNSIGNED_BYTE, rawData.data());
+                 GL_RGB, GL_UNSIGNED_BYTE, pixels);
     
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -175,6 +183,62 @@ struct MSDFAtlas {
     // Clear raw data after upload to save memory
     rawData.clear();
     rawData.shrink_to_fit();
+    cacheFile.reset();
+  }
+};
+
+// A page of on-demand glyphs - codepoints outside the prebuilt atlas, packed
+// into rows as they're rendered. Unlike the prebuilt atlas it keeps rawData, so
+// newly rendered glyphs can be uploaded as sub-rectangles.
+struct MSDFGlyphPage {
+  static constexpr int SIZE = 512;
+
+  GLuint textureID = 0;
+  std::vector<unsigned char> rawData = std::vector<unsigned char>(SIZE * SIZE * 3, 0);
+  int cursorX = 0, cursorY = 0, rowHeight = 0;
+  std::vector<int> codepoints;  // Glyphs packed here
+  uint64_t lastUsed = 0;        // When a glyph here was last drawn (for eviction)
+  uint64_t lastFrame = 0;       // Frame a glyph here was last drawn in
+  int dirtyX0 = SIZE, dirtyY0 = SIZE, dirtyX1 = 0, dirtyY1 = 0;  // Not yet uploaded
+
+  ~MSDFGlyphPage() {
+    if (textureID) {
+      glDeleteTextures(1, &textureID);
+    }
+  }
+
+  void markDirty(int x0, int y0, int x1, int y1) {
+    dirtyX0 = std::min(dirtyX0, x0);
+    dirtyY0 = std::min(dirtyY0, y0);
+    dirtyX1 = std::max(dirtyX1, x1);
+    dirtyY1 = std::max(dirtyY1, y1);
+  }
+
+  // Upload what changed since the last upload (must be called from main thread)
+  void uploadToGPU() {
+    if (textureID == 0) {
+      glGenTextures(1, &textureID);
+      glBindTexture(GL_TEXTURE_2D, textureID);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SIZE, SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, rawData.data());
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else if (dirtyX0 < dirtyX1 && dirtyY0 < dirtyY1) {
+      glBindTexture(GL_TEXTURE_2D, textureID);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, SIZE);
+      glPixelStorei(GL_UNPACK_SKIP_PIXELS, dirtyX0);
+      glPixelStorei(GL_UNPACK_SKIP_ROWS, dirtyY0);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, dirtyX0, dirtyY0, dirtyX1 - dirtyX0, dirtyY1 - dirtyY0,
+                      GL_RGB, GL_UNSIGNED_BYTE, rawData.data());
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+      glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+      glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    dirtyX0 = dirtyY0 = SIZE;
+    dirtyX1 = dirtyY1 = 0;
   }
 };
 
@@ -183,40 +247,51 @@ class MSDFFont {
   stbtt_fontinfo fontInfo;
   std::string fontPath;
   std::unique_ptr<MSDFAtlas> atlas;
+  WordWidthCache wordWidths;
   
   static constexpr float GLYPH_SIZE = 32.0f;      // Size to render glyphs at (balance quality/speed)
   static constexpr float PIXEL_RANGE = 4.0f;      // SDF range in pixels
   static constexpr int ATLAS_WIDTH = 512;         // Smaller atlas for faster generation
   static constexpr int ATLAS_HEIGHT = 512;
   static constexpr int GLYPH_PADDING = 2;         // Minimal padding for speed
+  static constexpr size_t MAX_GLYPH_PAGES = 8;    // On-demand pages before the LRU one is reused
+
+  // On-demand glyphs: codepoints above Latin-1 that the prebuilt atlas lacks.
+  // Their advances come from the font's metrics on first use, so layout is
+  // final at once; a worker thread renders their MSDFs into glyph pages,
+  // glyphs being drawn ahead of those only measured so far.
+  struct DynamicGlyph {
+    MSDFGlyph glyph;       // Advance and size from metrics; valid once it can be drawn
+    bool exists = false;   // The font has a glyph for the codepoint
+    bool hasShape = false; // It has an outline, still to be rendered if page < 0
+    int page = -1;         // Glyph page holding the rendered MSDF
+    bool queued = false;   // In the render queue (behind what's on screen)
+    bool urgent = false;   // In the render queue ahead of the rest (being drawn)
+  };
+  std::unordered_map<int, DynamicGlyph> dynamicGlyphs;
+  std::vector<std::unique_ptr<MSDFGlyphPage>> glyphPages;
+  size_t packingPage = 0;
+  uint64_t pageClock = 0;
+  std::deque<int> glyphQueue;
+  std::thread glyphWorker;
+  std::condition_variable glyphWake;
+  bool stopGlyphWorker = false;
+  bool fontInfoFailed = false;
+  mutable std::mutex dynamicMutex;  // Guards all of the above, and fontData/fontInfo once loaded
+  static inline std::atomic<uint64_t> currentFrame{1};  // See beginFrame
 
 public:
+  // Start a frame (Renderer::clear). A glyph page drawn from in the current
+  // frame isn't emptied for reuse: its glyphs' texture coordinates are out in
+  // the frame's draw calls, and a page can only be reused once the frame
+  // that referenced it has been submitted, which starting the next one means.
+  static void beginFrame() {
+    currentFrame.fetch_add(1, std::memory_order_relaxed);
+  }
+
   // Decode UTF-8 codepoint from string, returns codepoint and advances index
   static int decodeUTF8(const std::string &text, size_t &i) {
-    unsigned char c = text[i];
-    if ((c & 0x80) == 0) {
-      // ASCII (0xxxxxxx)
-      return c;
-    } else if ((c & 0xE0) == 0xC0 && i + 1 < text.length()) {
-      // 2-byte sequence (110xxxxx 10xxxxxx)
-      int cp = (c & 0x1F) << 6;
-      cp |= (text[++i] & 0x3F);
-      return cp;
-    } else if ((c & 0xF0) == 0xE0 && i + 2 < text.length()) {
-      // 3-byte sequence (1110xxxx 10xxxxxx 10xxxxxx)
-      int cp = (c & 0x0F) << 12;
-      cp |= (text[++i] & 0x3F) << 6;
-      cp |= (text[++i] & 0x3F);
-      return cp;
-    } else if ((c & 0xF8) == 0xF0 && i + 3 < text.length()) {
-      // 4-byte sequence (11110xxx 10xxxxxx 10xxxxxx 10xxxxxx)
-      int cp = (c & 0x07) << 18;
-      cp |= (text[++i] & 0x3F) << 12;
-      cp |= (text[++i] & 0x3F) << 6;
-      cp |= (text[++i] & 0x3F);
-      return cp;
-    }
-    return -1;  // Invalid
+    return skene::decodeUTF8(text, i);
   }
 
   MSDFFont() = default;
@@ -226,19 +301,31 @@ public:
   }
 
   ~MSDFFont() {
+    {
+      std::lock_guard<std::mutex> lock(dynamicMutex);
+      stopGlyphWorker = true;
+    }
+    glyphWake.notify_all();
+    if (glyphWorker.joinable()) {
+      glyphWorker.join();
+    }
     atlas.reset();
   }
   
   // Font is loaded if we have an atlas (either from cache or generated)
   // Note: textureID may be 0 if generated in thread but not yet uploaded
-  bool isLoaded() const { return atlas != nullptr && (atlas->textureID != 0 || !atlas->rawData.empty()); }
+  bool isLoaded() const { return atlas != nullptr && (atlas->textureID != 0 || atlas->pixelData()); }
   
   // Check if atlas has been uploaded to GPU (ready for rendering)
   bool isReadyForRendering() const { return atlas != nullptr && atlas->textureID != 0; }
   
+  // Set on threads without the GL context (the layout worker): fonts they load
+  // keep their atlas in rawData until bind() uploads it on the main thread
+  static inline thread_local bool deferGPUUpload = false;
+
   // Ensure GPU resources are ready (upload if needed - must call from main thread)
   void ensureGPUReady() {
-    if (atlas && atlas->textureID == 0 && !atlas->rawData.empty()) {
+    if (atlas && atlas->textureID == 0 && atlas->pixelData()) {
       atlas->uploadToGPU();
     }
   }
@@ -253,68 +340,12 @@ public:
   bool loadFromCacheOnly(const std::string &filename) {
     fontPath = filename;
     
-    std::string cacheDir = getMSDFCacheDirectory();
-    std::string cacheFile = cacheDir + "/" + getCacheFilename(fontPath);
-    
-    std::ifstream file(cacheFile, std::ios::binary);
-    if (!file) return false;
-    
-    // Read and verify header
-    uint32_t magic, version;
-    uint64_t storedHash;
-    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
-    file.read(reinterpret_cast<char*>(&version), sizeof(version));
-    file.read(reinterpret_cast<char*>(&storedHash), sizeof(storedHash));
-    
-    if (magic != MSDF_CACHE_MAGIC || version != MSDF_CACHE_VERSION) {
-      return false;
-    }
-    
     // Skip hash validation for speed - trust the cache
     // (full loadFont will validate if cache fails)
+    if (!readCache(false)) return false;
     
-    // Read atlas metadata
-    atlas = std::make_unique<MSDFAtlas>();
-    file.read(reinterpret_cast<char*>(&atlas->atlasWidth), sizeof(atlas->atlasWidth));
-    file.read(reinterpret_cast<char*>(&atlas->atlasHeight), sizeof(atlas->atlasHeight));
-    file.read(reinterpret_cast<char*>(&atlas->pixelRange), sizeof(atlas->pixelRange));
-    file.read(reinterpret_cast<char*>(&atlas->glyphSize), sizeof(atlas->glyphSize));
-    file.read(reinterpret_cast<char*>(&atlas->ascent), sizeof(atlas->ascent));
-    file.read(reinterpret_cast<char*>(&atlas->descent), sizeof(atlas->descent));
-    file.read(reinterpret_cast<char*>(&atlas->lineGap), sizeof(atlas->lineGap));
-    
-    // Read glyph count and data
-    uint32_t glyphCount;
-    file.read(reinterpret_cast<char*>(&glyphCount), sizeof(glyphCount));
-    for (uint32_t i = 0; i < glyphCount; ++i) {
-      int32_t codepoint;
-      MSDFGlyph glyph;
-      file.read(reinterpret_cast<char*>(&codepoint), sizeof(codepoint));
-      file.read(reinterpret_cast<char*>(&glyph), sizeof(glyph));
-      atlas->glyphs[codepoint] = glyph;
-    }
-    
-    // Read atlas texture data
-    size_t dataSize = atlas->atlasWidth * atlas->atlasHeight * 3;
-    std::vector<unsigned char> atlasData(dataSize);
-    file.read(reinterpret_cast<char*>(atlasData.data()), dataSize);
-    
-    if (!file) {
-      atlas.reset();
-      return false;
-    }
-    
-    // Upload texture to GPU
-    glGenTextures(1, &atlas->textureID);
-    glBindTexture(GL_TEXTURE_2D, atlas->textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, atlas->atlasWidth, atlas->atlasHeight, 0,
-                 GL_RGB, GL_UNSIGNED_BYTE, atlasData.data());
-    
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    
+    // Upload texture to GPU (or on first bind, off the GL thread)
+    if (!deferGPUUpload) atlas->uploadToGPU();
     return true;
   }
 
@@ -339,16 +370,17 @@ public:
       return;
     }
     
-    // Generate MSDF atlas (with GPU upload)
-    generateAtlas(true);
+    // Generate MSDF atlas (with GPU upload, unless off the GL thread)
+    generateAtlas(!deferGPUUpload);
     
     // Save to cache for future use
     saveToCache();
   }
   
   // Generate font cache without OpenGL (thread-safe, for background caching)
-  // Returns true if cache was successfully generated and saved
-  bool generateCacheOnly(const std::string &filename) {
+  // Returns true if cache was successfully generated and saved. glyphThreads
+  // is passed on to generateAtlas.
+  bool generateCacheOnly(const std::string &filename, unsigned glyphThreads = 0) {
     // Check if cache already exists
     fontPath = filename;
     std::string cacheDir = getMSDFCacheDirectory();
@@ -372,7 +404,7 @@ public:
     }
     
     // Generate atlas WITHOUT OpenGL upload
-    generateAtlas(false);
+    generateAtlas(false, glyphThreads);
     
     if (!atlas || atlas->rawData.empty()) {
       std::cerr << "MSDF: [Thread] Failed to generate atlas: " << filename << std::endl;
@@ -391,72 +423,10 @@ public:
 
   // Load atlas from disk cache (with full validation)
   bool loadFromCache() {
-    std::string cacheDir = getMSDFCacheDirectory();
-    std::string cacheFile = cacheDir + "/" + getCacheFilename(fontPath);
-    
-    std::ifstream file(cacheFile, std::ios::binary);
-    if (!file) return false;
-    
-    // Read and verify header
-    uint32_t magic, version;
-    uint64_t storedHash;
-    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
-    file.read(reinterpret_cast<char*>(&version), sizeof(version));
-    file.read(reinterpret_cast<char*>(&storedHash), sizeof(storedHash));
-    
-    if (magic != MSDF_CACHE_MAGIC || version != MSDF_CACHE_VERSION) {
-      return false;  // Invalid or old cache format
-    }
-    
-    // Verify font file hasn't changed
-    uint64_t currentHash = computeFontFileHash(fontPath);
-    if (storedHash != currentHash) {
-      std::cout << "MSDF: Cache invalidated (font changed): " << fontPath << std::endl;
-      return false;
-    }
-    
-    // Read atlas metadata
-    atlas = std::make_unique<MSDFAtlas>();
-    file.read(reinterpret_cast<char*>(&atlas->atlasWidth), sizeof(atlas->atlasWidth));
-    file.read(reinterpret_cast<char*>(&atlas->atlasHeight), sizeof(atlas->atlasHeight));
-    file.read(reinterpret_cast<char*>(&atlas->pixelRange), sizeof(atlas->pixelRange));
-    file.read(reinterpret_cast<char*>(&atlas->glyphSize), sizeof(atlas->glyphSize));
-    file.read(reinterpret_cast<char*>(&atlas->ascent), sizeof(atlas->ascent));
-    file.read(reinterpret_cast<char*>(&atlas->descent), sizeof(atlas->descent));
-    file.read(reinterpret_cast<char*>(&atlas->lineGap), sizeof(atlas->lineGap));
-    
-    // Read glyph count and data
-    uint32_t glyphCount;
-    file.read(reinterpret_cast<char*>(&glyphCount), sizeof(glyphCount));
-    for (uint32_t i = 0; i < glyphCount; ++i) {
-      int32_t codepoint;
-      MSDFGlyph glyph;
-      file.read(reinterpret_cast<char*>(&codepoint), sizeof(codepoint));
-      file.read(reinterpret_cast<char*>(&glyph), sizeof(glyph));
-      atlas->glyphs[codepoint] = glyph;
-    }
-    
-    // Read atlas texture data
-    size_t dataSize = atlas->atlasWidth * atlas->atlasHeight * 3;
-    std::vector<unsigned char> atlasData(dataSize);
-    file.read(reinterpret_cast<char*>(atlasData.data()), dataSize);
-    
-    if (!file) {
-      atlas.reset();
-      return false;  // Read error
-    }
+    if (!readCache(true)) return false;
     
     // Upload texture to GPU
-    glGenTextures(1, &atlas->textureID);
-    glBindTexture(GL_TEXTURE_2D, atlas->textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, atlas->atlasWidth, atlas->atlasHeight, 0,
-                 GL_RGB, GL_UNSIGNED_BYTE, atlasData.data());
-    
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    
+    atlas->uploadToGPU();
     return true;
   }
   
@@ -468,62 +438,46 @@ public:
     std::string cacheFile = cacheDir + "/" + getCacheFilename(fontPath);
     
     // Get atlas data from rawData or from GPU
-    std::vector<unsigned char>* atlasDataPtr = nullptr;
+    const unsigned char *atlasPixels = atlas->pixelData();
     std::vector<unsigned char> gpuData;
     
-    if (!atlas->rawData.empty()) {
-      // Use rawData directly (thread-safe, no OpenGL)
-      atlasDataPtr = &atlas->rawData;
-    } else if (atlas->textureID != 0) {
+    if (!atlasPixels && atlas->textureID != 0) {
       // Read back from GPU (only on main thread)
       gpuData.resize(atlas->atlasWidth * atlas->atlasHeight * 3);
       glBindTexture(GL_TEXTURE_2D, atlas->textureID);
       glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, gpuData.data());
-      atlasDataPtr = &gpuData;
-    } else {
+      atlasPixels = gpuData.data();
+    } else if (!atlasPixels) {
       std::cerr << "MSDF: No atlas data to save for: " << fontPath << std::endl;
       return;
     }
     
-    std::ofstream file(cacheFile, std::ios::binary);
-    if (!file) {
+    MSDFCacheHeader header;
+    header.fontHash = computeFontFileHash(fontPath);
+    header.atlasWidth = atlas->atlasWidth;
+    header.atlasHeight = atlas->atlasHeight;
+    header.pixelRange = atlas->pixelRange;
+    header.glyphSize = atlas->glyphSize;
+    header.ascent = atlas->ascent;
+    header.descent = atlas->descent;
+    header.lineGap = atlas->lineGap;
+    
+    std::vector<MSDFCacheGlyph> glyphs;
+    glyphs.reserve(atlas->glyphs.size());
+    atlas->glyphs.forEach([&](int codepoint, const MSDFGlyph &glyph) {
+      glyphs.push_back(MSDFCacheGlyph{codepoint, glyph});
+    });
+    
+    if (!MSDFCacheFile::write(cacheFile, header, glyphs, atlasPixels)) {
       std::cerr << "MSDF: Failed to save cache: " << cacheFile << std::endl;
       return;
     }
     
-    // Write header
-    uint32_t magic = MSDF_CACHE_MAGIC;
-    uint32_t version = MSDF_CACHE_VERSION;
-    uint64_t fontHash = computeFontFileHash(fontPath);
-    file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
-    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
-    file.write(reinterpret_cast<const char*>(&fontHash), sizeof(fontHash));
-    
-    // Write atlas metadata
-    file.write(reinterpret_cast<const char*>(&atlas->atlasWidth), sizeof(atlas->atlasWidth));
-    file.write(reinterpret_cast<const char*>(&atlas->atlasHeight), sizeof(atlas->atlasHeight));
-    file.write(reinterpret_cast<const char*>(&atlas->pixelRange), sizeof(atlas->pixelRange));
-    file.write(reinterpret_cast<const char*>(&atlas->glyphSize), sizeof(atlas->glyphSize));
-    file.write(reinterpret_cast<const char*>(&atlas->ascent), sizeof(atlas->ascent));
-    file.write(reinterpret_cast<const char*>(&atlas->descent), sizeof(atlas->descent));
-    file.write(reinterpret_cast<const char*>(&atlas->lineGap), sizeof(atlas->lineGap));
-    
-    // Write glyph count and data
-    uint32_t glyphCount = static_cast<uint32_t>(atlas->glyphs.size());
-    file.write(reinterpret_cast<const char*>(&glyphCount), sizeof(glyphCount));
-    for (const auto& [codepoint, glyph] : atlas->glyphs) {
-      int32_t cp = codepoint;
-      file.write(reinterpret_cast<const char*>(&cp), sizeof(cp));
-      file.write(reinterpret_cast<const char*>(&glyph), sizeof(glyph));
-    }
-    
-    // Write atlas texture data
-    file.write(reinterpret_cast<const char*>(atlasDataPtr->data()), atlasDataPtr->size());
-    
     std::cout << "MSDF: Saved to cache: " << std::filesystem::path(cacheFile).filename().string() << std::endl;
   }
 
   void bind() {
+    ensureGPUReady();
     if (atlas && atlas->textureID) {
       glBindTexture(GL_TEXTURE_2D, atlas->textureID);
     }
@@ -532,28 +486,67 @@ public:
   // Get glyph info for rendering
   const MSDFGlyph* getGlyph(int charCode) const {
     if (!atlas) return nullptr;
-    auto it = atlas->glyphs.find(charCode);
-    if (it != atlas->glyphs.end() && it->second.valid) {
-      return &it->second;
+    return atlas->glyphs.find(charCode);
+  }
+
+  // A glyph to draw, and the texture it's in: page -1 is the prebuilt atlas,
+  // others are glyph pages (see bindPage). An on-demand glyph that isn't
+  // rendered yet has its advance but isn't valid.
+  struct DrawGlyph {
+    MSDFGlyph glyph;
+    int page = -1;
+  };
+
+  // Look up a glyph for drawing; false if the font has none
+  bool getDrawGlyph(int charCode, DrawGlyph &out) {
+    if (!atlas) return false;
+    if (const MSDFGlyph *glyph = atlas->glyphs.find(charCode)) {
+      out.glyph = *glyph;
+      out.page = -1;
+      return true;
+    }
+    if (charCode < GlyphTable::PAGE_SIZE || atlas->glyphs.contains(charCode)) return false;
+    
+    std::lock_guard<std::mutex> lock(dynamicMutex);
+    const DynamicGlyph &entry = lookupDynamicGlyph(charCode, true);
+    if (!entry.exists) return false;
+    if (entry.page >= 0) {
+      MSDFGlyphPage &page = *glyphPages[entry.page];
+      page.lastUsed = ++pageClock;
+      page.lastFrame = currentFrame.load(std::memory_order_relaxed);
+    }
+    out.glyph = entry.glyph;
+    out.page = entry.page;
+    return true;
+  }
+
+  // Bind the texture a DrawGlyph's page is in, uploading glyphs rendered since
+  // it was last bound (must be called from main thread)
+  void bindPage(int page) {
+    if (page < 0) {
+      bind();
+      return;
     }
-    return nullptr;
+    std::lock_guard<std::mutex> lock(dynamicMutex);
+    MSDFGlyphPage &glyphPage = *glyphPages[page];
+    glyphPage.uploadToGPU();
+    glBindTexture(GL_TEXTURE_2D, glyphPage.textureID);
   }
 
   // Get text width at given font size (handles UTF-8)
   float getTextWidth(const std::string &text, float fontSize) {
+    if (!atlas) return 0;
+    return atlas->glyphs.measure(text, fontSize / atlas->glyphSize,
+                                 [this](int cp) { return dynamicAdvance(cp); });
+  }
+
+  // getTextWidth for a word of running text. Long words are remembered for
+  // the next rewrap; the rest are summed faster than they'd be looked up.
+  float getWordWidth(std::string_view word, float fontSize) {
     if (!atlas) return 0;
     float scale = fontSize / atlas->glyphSize;
-    float width = 0;
-    
-    for (size_t i = 0; i < text.length(); ++i) {
-      int cp = decodeUTF8(text, i);
-      if (cp < 32) continue;
-      auto it = atlas->glyphs.find(cp);
-      if (it != atlas->glyphs.end() && it->second.valid) {
-        width += it->second.advance * scale;
-      }
-    }
-    return width;
+    if (WordWidthCache::worthCaching(word)) return cachedWordWidth(word) * scale;
+    return measureWord(word) * scale;
   }
 
   // Get character positions for hit testing (handles UTF-8)
@@ -565,16 +558,18 @@ public:
     float x = 0;
     positions.push_back(0);
     
+    if (float advance = monospaceAdvance(text) * scale; advance > 0) {
+      for (size_t i = 1; i <= text.length(); ++i) positions.push_back(advance * i);
+      return positions;
+    }
+    
     for (size_t i = 0; i < text.length(); ++i) {
       int cp = decodeUTF8(text, i);
       if (cp < 32) {
         positions.push_back(x);
         continue;
       }
-      auto it = atlas->glyphs.find(cp);
-      if (it != atlas->glyphs.end() && it->second.valid) {
-        x += it->second.advance * scale;
-      }
+      x += advanceOf(cp) * scale;
       positions.push_back(x);
     }
     return positions;
@@ -588,15 +583,18 @@ public:
     float x = 0;
     float prevX = 0;
     
+    if (float advance = monospaceAdvance(text) * scale; advance > 0) {
+      // Index of the first character whose midpoint is past localX
+      size_t index = static_cast<size_t>(std::floor(localX / advance + 0.5f));
+      return std::min(index, text.length());
+    }
+    
     for (size_t i = 0; i < text.length(); ++i) {
       size_t charStart = i;
       int cp = decodeUTF8(text, i);
       if (cp < 32) continue;
       
-      auto it = atlas->glyphs.find(cp);
-      if (it != atlas->glyphs.end() && it->second.valid) {
-        x += it->second.advance * scale;
-      }
+      x += advanceOf(cp) * scale;
       
       float midpoint = prevX + (x - prevX) / 2.0f;
       if (localX < midpoint) {
@@ -617,6 +615,10 @@ public:
     float x = 0;
     size_t charIndex = 0;
     
+    if (float advance = monospaceAdvance(text) * scale; advance > 0) {
+      return advance * (std::min(end, text.length()) - start);
+    }
+    
     for (size_t i = 0; i < text.length() && charIndex < end; ++i) {
       int cp = decodeUTF8(text, i);
       if (cp < 32) {
@@ -628,10 +630,7 @@ public:
         startX = x;
       }
       
-      auto it = atlas->glyphs.find(cp);
-      if (it != atlas->glyphs.end() && it->second.valid) {
-        x += it->second.advance * scale;
-      }
+      x += advanceOf(cp) * scale;
       charIndex++;
     }
     
@@ -646,6 +645,10 @@ public:
     float x = 0;
     size_t charIndex = 0;
     
+    if (float advance = monospaceAdvance(text) * scale; advance > 0) {
+      return advance * std::min(index, text.length());
+    }
+    
     for (size_t i = 0; i < text.length() && charIndex < index; ++i) {
       int cp = decodeUTF8(text, i);
       if (cp < 32) {
@@ -653,10 +656,7 @@ public:
         continue;
       }
       
-      auto it = atlas->glyphs.find(cp);
-      if (it != atlas->glyphs.end() && it->second.valid) {
-        x += it->second.advance * scale;
-      }
+      x += advanceOf(cp) * scale;
       charIndex++;
     }
     
@@ -676,6 +676,218 @@ public:
   }
 
 private:
+  // Width of a word at the atlas glyph size
+  float measureWord(std::string_view word) {
+    return atlas->glyphs.measure(word, 1.0f, [this](int cp) { return dynamicAdvance(cp); });
+  }
+
+  // Through the word cache. A function of its own, so the lookup isn't
+  // inlined into getWordWidth's path for ordinary words (see glyph-bench).
+  float cachedWordWidth(std::string_view word) {
+    return wordWidths.get(word, [this](std::string_view w) { return measureWord(w); });
+  }
+
+  // Advance at the atlas glyph size, on-demand glyphs included
+  float advanceOf(int codepoint) {
+    return atlas->glyphs.advance(codepoint, [this](int cp) { return dynamicAdvance(cp); });
+  }
+
+  // Advance of a codepoint missing from the prebuilt atlas (0 if the font lacks it)
+  float dynamicAdvance(int codepoint) {
+    std::lock_guard<std::mutex> lock(dynamicMutex);
+    const DynamicGlyph &entry = lookupDynamicGlyph(codepoint, false);
+    return entry.exists ? entry.glyph.advance : 0.0f;
+  }
+
+  // Find or create the on-demand glyph for a codepoint, queueing it to be
+  // rendered - ahead of the rest if it's being drawn (dynamicMutex held)
+  const DynamicGlyph &lookupDynamicGlyph(int codepoint, bool drawing) {
+    auto it = dynamicGlyphs.find(codepoint);
+    if (it == dynamicGlyphs.end()) {
+      it = dynamicGlyphs.emplace(codepoint, measureDynamicGlyph(codepoint)).first;
+    }
+    DynamicGlyph &entry = it->second;
+    if (entry.hasShape && entry.page < 0 && (drawing ? !entry.urgent : !entry.queued)) {
+      if (drawing) {
+        glyphQueue.push_front(codepoint);
+        entry.urgent = true;
+      } else {
+        glyphQueue.push_back(codepoint);
+        entry.queued = true;
+      }
+      if (!glyphWorker.joinable()) {
+        glyphWorker = std::thread([this] { renderDynamicGlyphs(); });
+      }
+      glyphWake.notify_one();
+    }
+    return entry;
+  }
+
+  // Metrics for an on-demand glyph, laid out as generateAtlas would pack it
+  DynamicGlyph measureDynamicGlyph(int codepoint) {
+    DynamicGlyph entry;
+    if (!ensureFontInfo()) return entry;
+    int glyphIndex = stbtt_FindGlyphIndex(&fontInfo, codepoint);
+    if (glyphIndex == 0) return entry;
+    
+    float scale = stbtt_ScaleForMappingEmToPixels(&fontInfo, atlas->glyphSize);
+    int advanceWidth, leftSideBearing;
+    stbtt_GetGlyphHMetrics(&fontInfo, glyphIndex, &advanceWidth, &leftSideBearing);
+    int x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBox(&fontInfo, glyphIndex, scale, scale, &x0, &y0, &x1, &y1);
+    
+    entry.exists = true;
+    entry.glyph = MSDFGlyph{};
+    entry.glyph.advance = advanceWidth * scale;
+    if (x1 <= x0 || y1 <= y0 || !hasGlyphShape(codepoint)) {
+      entry.glyph.valid = true;  // Blank - nothing to render
+      return entry;
+    }
+    entry.hasShape = true;
+    entry.glyph.width = (float)(x1 - x0 + GLYPH_PADDING * 2);
+    entry.glyph.height = (float)(y1 - y0 + GLYPH_PADDING * 2);
+    entry.glyph.xoff = x0 - GLYPH_PADDING;
+    entry.glyph.yoff = y0 - GLYPH_PADDING;
+    return entry;
+  }
+
+  // Parse the font file for on-demand glyphs - fonts loaded from cache haven't
+  // (dynamicMutex held)
+  bool ensureFontInfo() {
+    if (!fontData.empty()) return true;
+    if (fontInfoFailed || fontPath.empty()) return false;
+    std::ifstream file(fontPath, std::ios::binary);
+    if (file) {
+      fontData = std::vector<unsigned char>(std::istreambuf_iterator<char>(file), {});
+    }
+    if (fontData.empty() || !stbtt_InitFont(&fontInfo, fontData.data(), 0)) {
+      std::cerr << "MSDF: Failed to load font for on-demand glyphs: " << fontPath << std::endl;
+      fontData.clear();
+      fontInfoFailed = true;
+      return false;
+    }
+    return true;
+  }
+
+  // Glyph worker: render queued glyphs one at a time, outside the lock
+  void renderDynamicGlyphs() {
+    std::unique_lock<std::mutex> lock(dynamicMutex);
+    while (true) {
+      glyphWake.wait(lock, [this] { return stopGlyphWorker || !glyphQueue.empty(); });
+      if (stopGlyphWorker) return;
+      int codepoint = glyphQueue.front();
+      glyphQueue.pop_front();
+      
+      DynamicGlyph &entry = dynamicGlyphs[codepoint];
+      if (!entry.hasShape || entry.page >= 0) continue;  // Queued twice
+      int width = (int)entry.glyph.width;
+      int height = (int)entry.glyph.height;
+      float glyphSize = atlas->glyphSize;
+      float pixelRange = atlas->pixelRange;
+      
+      lock.unlock();
+      std::vector<unsigned char> bitmap(width * height * 3, 0);
+      bool rendered = generateGlyphMSDF(codepoint, 0, 0, width, height, bitmap, width,
+                                        glyphSize, pixelRange);
+      lock.lock();
+      
+      DynamicGlyph &done = dynamicGlyphs[codepoint];
+      done.queued = done.urgent = false;
+      if (!rendered) {
+        done.hasShape = false;
+        done.glyph.valid = true;
+        done.glyph.width = done.glyph.height = 0;
+        continue;
+      }
+      placeDynamicGlyph(codepoint, done, bitmap);
+    }
+  }
+
+  // Copy a rendered glyph into a glyph page - the one being filled, a new one,
+  // or else the least recently drawn one not drawn this frame, emptied. If the
+  // frame draws from every page, another one is added past MAX_GLYPH_PAGES
+  // rather than pulling glyphs from under it (dynamicMutex held)
+  void placeDynamicGlyph(int codepoint, DynamicGlyph &entry, const std::vector<unsigned char> &bitmap) {
+    const int size = MSDFGlyphPage::SIZE;
+    int width = (int)entry.glyph.width;
+    int height = (int)entry.glyph.height;
+    if (width > size - GLYPH_PADDING * 2 || height > size - GLYPH_PADDING * 2) {
+      entry.hasShape = false;  // Too big for a page
+      entry.glyph.valid = true;
+      entry.glyph.width = entry.glyph.height = 0;
+      return;
+    }
+    
+    auto fits = [&](MSDFGlyphPage &page) {
+      if (page.cursorX + width > size - GLYPH_PADDING) {
+        page.cursorX = GLYPH_PADDING;
+        page.cursorY += page.rowHeight + GLYPH_PADDING;
+        page.rowHeight = 0;
+      }
+      return page.cursorY + height <= size - GLYPH_PADDING;
+    };
+    if (glyphPages.empty() || !fits(*glyphPages[packingPage])) {
+      uint64_t frame = currentFrame.load(std::memory_order_relaxed);
+      size_t reusable = glyphPages.size();
+      if (glyphPages.size() >= MAX_GLYPH_PAGES) {
+        for (size_t i = 0; i < glyphPages.size(); ++i) {
+          if (glyphPages[i]->lastFrame >= frame) continue;
+          if (reusable == glyphPages.size() || glyphPages[i]->lastUsed < glyphPages[reusable]->lastUsed) {
+            reusable = i;
+          }
+        }
+      }
+      if (reusable < glyphPages.size()) {
+        packingPage = reusable;
+        evictGlyphPage(*glyphPages[packingPage]);
+      } else {
+        glyphPages.push_back(std::make_unique<MSDFGlyphPage>());
+        packingPage = glyphPages.size() - 1;
+      }
+      MSDFGlyphPage &fresh = *glyphPages[packingPage];
+      fresh.cursorX = fresh.cursorY = GLYPH_PADDING;
+      fresh.rowHeight = 0;
+    }
+    
+    MSDFGlyphPage &page = *glyphPages[packingPage];
+    int x = page.cursorX, y = page.cursorY;
+    for (int row = 0; row < height; ++row) {
+      std::memcpy(&page.rawData[((y + row) * size + x) * 3], &bitmap[row * width * 3], width * 3);
+    }
+    page.markDirty(x, y, x + width, y + height);
+    page.codepoints.push_back(codepoint);
+    page.lastUsed = ++pageClock;
+    page.cursorX += width + GLYPH_PADDING;
+    page.rowHeight = std::max(page.rowHeight, height);
+    
+    entry.page = static_cast<int>(packingPage);
+    entry.glyph.valid = true;
+    entry.glyph.u0 = (float)x / size;
+    entry.glyph.v0 = (float)y / size;
+    entry.glyph.u1 = (float)(x + width) / size;
+    entry.glyph.v1 = (float)(y + height) / size;
+  }
+
+  // Empty a glyph page for reuse; its glyphs are rendered again when next used
+  void evictGlyphPage(MSDFGlyphPage &page) {
+    for (int codepoint : page.codepoints) {
+      DynamicGlyph &entry = dynamicGlyphs[codepoint];
+      entry.page = -1;
+      entry.glyph.valid = false;
+    }
+    page.codepoints.clear();
+    std::fill(page.rawData.begin(), page.rawData.end(), 0);
+    page.markDirty(0, 0, MSDFGlyphPage::SIZE, MSDFGlyphPage::SIZE);
+  }
+
+  // Advance of each character of text if this is a fixed-pitch font and text is
+  // printable ASCII - one character per byte, so positions are just
+  // index * advance - otherwise 0
+  float monospaceAdvance(const std::string &text) const {
+    float advance = atlas->glyphs.fixedAdvance();
+    return advance > 0 && GlyphTable::isPrintableAscii(text) ? advance : 0;
+  }
+
   // Get list of codepoints to include in atlas
   static std::vector<int> getCharacterSet() {
     std::vector<int> chars;
@@ -704,10 +916,49 @@ private:
     return chars;
   }
 
-  void generateAtlas(bool uploadToGPU = true) {
+  // Take the atlas from the mapped cache file: the glyph table is read in
+  // place, and uncompressed pixels stay mapped until uploadToGPU copies them
+  // out. validateFontHash rejects caches of a since-changed font file.
+  bool readCache(bool validateFontHash) {
+    std::string cacheFile = getMSDFCacheDirectory() + "/" + getCacheFilename(fontPath);
+    auto file = MSDFCacheFile::open(cacheFile);
+    if (!file) return false;
+    
+    const MSDFCacheHeader &header = file->header();
+    if (validateFontHash && header.fontHash != computeFontFileHash(fontPath)) {
+      std::cout << "MSDF: Cache invalidated (font changed): " << fontPath << std::endl;
+      return false;
+    }
+    
+    auto loaded = std::make_unique<MSDFAtlas>();
+    loaded->atlasWidth = header.atlasWidth;
+    loaded->atlasHeight = header.atlasHeight;
+    loaded->pixelRange = header.pixelRange;
+    loaded->glyphSize = header.glyphSize;
+    loaded->ascent = header.ascent;
+    loaded->descent = header.descent;
+    loaded->lineGap = header.lineGap;
+    
+    const MSDFCacheGlyph *glyphs = file->glyphs();
+    for (uint32_t i = 0; i < header.glyphCount; ++i) {
+      loaded->glyphs.set(glyphs[i].codepoint, glyphs[i].glyph);
+    }
+    
+    if (header.compression == MSDF_CACHE_RAW) {
+      loaded->cacheFile = std::move(file);
+    } else if (!file->decodePixels(loaded->rawData)) {
+      return false;
+    }
+    atlas = std::move(loaded);
+    return true;
+  }
+
+  // Render glyphs into the atlas: a serial pass packs every glyph into its own
+  // region, then threads (0 = one per core) render the MSDFs into those
+  // disjoint regions in parallel
+  void generateAtlas(bool uploadToGPU = true, unsigned threads = 0) {
     atlas = std::make_unique<MSDFAtlas>();
     atlas->atlasWidth = ATLAS_WIDTH;
-    atlas->atlasHeight = ATLAS_HEIGHT;
     atlas->pixelRange = PIXEL_RANGE;
     atlas->glyphSize = GLYPH_SIZE;
     
@@ -720,14 +971,21 @@ private:
     atlas->descent = -descent * scale;  // descent is negative in stb
     atlas->lineGap = lineGap * scale;
     
-    // Create atlas bitmap (RGB for MSDF) - store in rawData
-    atlas->rawData.resize(ATLAS_WIDTH * ATLAS_HEIGHT * 3, 0);
-    
     // Pack glyphs into atlas
     int cursorX = GLYPH_PADDING;
     int cursorY = GLYPH_PADDING;
     int rowHeight = 0;
     
+    // Glyphs in character set order; those with a region still need rendering
+    struct PackedGlyph {
+      int codepoint;
+      MSDFGlyph glyph;
+      int x = 0, y = 0, width = 0, height = 0;
+      bool rendered = true;
+    };
+    std::vector<PackedGlyph> packed;
+    std::vector<size_t> toRender;
+    
     std::vector<int> charSet = getCharacterSet();
     
     for (int c : charSet) {
@@ -759,7 +1017,12 @@ private:
         glyph.xoff = 0;
         glyph.yoff = 0;
         glyph.u0 = glyph.v0 = glyph.u1 = glyph.v1 = 0;
-        atlas->glyphs[c] = glyph;
+        packed.push_back(PackedGlyph{c, glyph});
+        continue;
+      }
+      
+      // Glyphs without an outline get no MSDF (and no region)
+      if (!hasGlyphShape(c)) {
         continue;
       }
       
@@ -780,11 +1043,6 @@ private:
         break;
       }
       
-      // Generate MSDF for this glyph (uses atlas->rawData)
-      if (!generateGlyphMSDF(c, cursorX, cursorY, paddedW, paddedH, atlas->rawData)) {
-        continue;
-      }
-      
       // Store glyph info
       glyph.valid = true;
       glyph.width = (float)paddedW;
@@ -792,16 +1050,51 @@ private:
       glyph.xoff = x0 - GLYPH_PADDING;
       glyph.yoff = y0 - GLYPH_PADDING;
       glyph.u0 = (float)cursorX / ATLAS_WIDTH;
-      glyph.v0 = (float)cursorY / ATLAS_HEIGHT;
       glyph.u1 = (float)(cursorX + paddedW) / ATLAS_WIDTH;
-      glyph.v1 = (float)(cursorY + paddedH) / ATLAS_HEIGHT;
-      atlas->glyphs[c] = glyph;
+      toRender.push_back(packed.size());
+      packed.push_back(PackedGlyph{c, glyph, cursorX, cursorY, paddedW, paddedH, false});
       
       // Advance cursor
       cursorX += paddedW + GLYPH_PADDING;
       rowHeight = std::max(rowHeight, paddedH);
     }
     
+    // The atlas is only as tall as the rows used, so the texture and the cache
+    // file don't carry empty rows
+    atlas->atlasHeight = std::min(ATLAS_HEIGHT, cursorY + rowHeight + GLYPH_PADDING);
+    for (size_t index : toRender) {
+      PackedGlyph &entry = packed[index];
+      entry.glyph.v0 = (float)entry.y / atlas->atlasHeight;
+      entry.glyph.v1 = (float)(entry.y + entry.height) / atlas->atlasHeight;
+    }
+    
+    // Create atlas bitmap (RGB for MSDF) - store in rawData
+    atlas->rawData.resize(ATLAS_WIDTH * atlas->atlasHeight * 3, 0);
+    
+    // Render the MSDFs - each glyph writes only its own region of rawData
+    std::atomic<size_t> next{0};
+    auto renderGlyphs = [&] {
+      for (size_t i = next++; i < toRender.size(); i = next++) {
+        PackedGlyph &entry = packed[toRender[i]];
+        entry.rendered = generateGlyphMSDF(entry.codepoint, entry.x, entry.y,
+                                           entry.width, entry.height, atlas->rawData);
+      }
+    };
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, toRender.size()));
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; ++t) {
+      workers.emplace_back(renderGlyphs);
+    }
+    renderGlyphs();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    
+    for (const auto &entry : packed) {
+      if (entry.rendered) atlas->glyphs.set(entry.codepoint, entry.glyph);
+    }
+    
     std::cout << "MSDF: Generated atlas for " << std::filesystem::path(fontPath).filename().string() << std::endl;
     
     // Optionally upload to GPU (skip when generating in worker thread)
@@ -810,8 +1103,17 @@ private:
     }
   }
 
+  // Whether a glyph has an outline to render (generateGlyphMSDF would succeed)
+  bool hasGlyphShape(int charCode) const {
+    stbtt_vertex* vertices = nullptr;
+    int numVerts = stbtt_GetCodepointShape(&fontInfo, charCode, &vertices);
+    if (vertices) stbtt_FreeShape(&fontInfo, vertices);
+    return numVerts > 0;
+  }
+
   bool generateGlyphMSDF(int charCode, int atlasX, int atlasY, int width, int height,
-                         std::vector<unsigned char>& atlasData) {
+                         std::vector<unsigned char>& atlasData, int atlasWidth = ATLAS_WIDTH,
+                         float glyphSize = GLYPH_SIZE, float pixelRange = PIXEL_RANGE) {
     // Get glyph shape from stb_truetype
     stbtt_vertex* vertices = nullptr;
     int numVerts = stbtt_GetCodepointShape(&fontInfo, charCode, &vertices);
@@ -825,7 +1127,7 @@ private:
     msdfgen::Contour* contour = nullptr;
     
     // Use em-based scaling like browsers do (font-size = em-square, not pixel height)
-    float scale = stbtt_ScaleForMappingEmToPixels(&fontInfo, GLYPH_SIZE);
+    float scale = stbtt_ScaleForMappingEmToPixels(&fontInfo, glyphSize);
     
     // Get glyph bounding box in font units
     int ix0, iy0, ix1, iy1;
@@ -914,12 +1216,12 @@ private:
     
     // Generate MSDF
     msdfgen::Bitmap<float, 3> msdf(width, height);
-    msdfgen::generateMSDF(msdf, shape, PIXEL_RANGE, 1.0, msdfgen::Vector2(0, 0));
+    msdfgen::generateMSDF(msdf, shape, pixelRange, 1.0, msdfgen::Vector2(0, 0));
     
     // Copy to atlas - MSDF bitmap is bottom-up, atlas texture is top-down
     for (int y = 0; y < height; ++y) {
       for (int x = 0; x < width; ++x) {
-        int atlasIdx = ((atlasY + y) * ATLAS_WIDTH + (atlasX + x)) * 3;
+        int atlasIdx = ((atlasY + y) * atlasWidth + (atlasX + x)) * 3;
         // Flip Y: msdfgen row 0 is bottom, we want row 0 to be top
         float* pixel = msdf(x, height - 1 - y);
         // MSDF values are typically in range [0, 1] from msdfgen
@@ -933,18 +1235,6 @@ private:
   }
 };
 
-// Font weight and style enums (matching Font.hpp)
-enum class MSDFFontWeight { Normal, Bold, Lighter, Bolder };
-enum class MSDFFontStyle { Normal, Italic, Oblique };
-
-// Structure to hold discovered system font info
-struct SystemFontInfo {
-  std::string path;
-  std::string familyName;
-  MSDFFontWeight weight;
-  MSDFFontStyle style;
-};
-
 // Simple thread pool for parallel font cache generation
 class FontCacheThreadPool {
   std::vector<std::thread> workers;
@@ -1049,14 +1339,29 @@ public:
 // MSDF Font manager - handles multiple font families with weight/style variants
 // Includes background thread for font discovery and pre-caching with thread pool
 class MSDFFontManager {
+  // A registered font file, loaded on first use. Entries are shared by
+  // aliases and registry snapshots, and all of them are kept in allEntries, so
+  // a loaded font is never freed while the manager lives.
   struct FontEntry {
     std::string path;
     std::unique_ptr<MSDFFont> font;  // nullptr until loaded
-    bool loadAttempted = false;
-    bool isCached = false;  // true if cache file exists
+    std::atomic<MSDFFont*> loaded{nullptr};  // font, once loaded - read without locking
+    std::atomic<bool> loadAttempted{false};
+    std::atomic<bool> isCached{false};  // true if cache file exists
+    std::mutex loadMutex;  // Held while loading
+    
+    FontEntry(std::string path, bool cached) : path(std::move(path)), isCached(cached) {}
+  };
+  
+  // The registry as font lookups see it: an immutable snapshot, replaced whole
+  // when fonts are registered, so lookups never lock
+  struct FontRegistry {
+    std::map<std::string, std::shared_ptr<FontEntry>> fonts;
+    uint64_t generation = 0;
   };
   
-  std::map<std::string, FontEntry> fonts;
+  std::map<std::string, std::shared_ptr<FontEntry>> fonts;  // Being registered into (fontsMutex)
+  std::vector<std::shared_ptr<FontEntry>> allEntries;  // Every entry registered, replaced ones too (fontsMutex)
   std::set<std::string> knownFontPaths;  // All discovered font file paths
   std::set<std::string> pathsBeingCached;  // Paths currently being cached by thread pool
   std::string defaultSerifPath;
@@ -1067,19 +1372,51 @@ class MSDFFontManager {
   mutable std::mutex fontsMutex;
   mutable std::mutex cachingMutex;  // For pathsBeingCached
   
+  // The published registry, and its generation for lookups that only need to
+  // know it hasn't changed. A thread reading a snapshot announces it in its
+  // reader slot first (see readRegistry); a replaced snapshot is freed once no
+  // slot holds it.
+  std::atomic<const FontRegistry*> registry{nullptr};
+  std::atomic<uint64_t> publishedGeneration{0};
+  std::vector<std::unique_ptr<const FontRegistry>> retiredRegistries;  // Replaced, maybe still read (fontsMutex)
+  static inline std::atomic<uint64_t> nextGeneration{1};  // Unique across managers
+  
+  // The registry snapshot a thread is reading, if any. Slots are per thread,
+  // shared by all managers, and never removed.
+  struct ReaderSlot {
+    std::atomic<const FontRegistry*> reading{nullptr};
+  };
+  static inline std::mutex readerSlotsMutex;
+  static inline std::vector<std::shared_ptr<ReaderSlot>> readerSlots;
+  
+  static ReaderSlot& readerSlot() {
+    thread_local std::shared_ptr<ReaderSlot> slot = [] {
+      auto created = std::make_shared<ReaderSlot>();
+      std::lock_guard<std::mutex> lock(readerSlotsMutex);
+      readerSlots.push_back(created);
+      return created;
+    }();
+    return *slot;
+  }
+  
   // Thread pool for parallel font cache generation
   std::unique_ptr<FontCacheThreadPool> cacheThreadPool;
   
+  // Fonts on disk and their cache status, remembered across runs
+  FontCatalog catalog{getMSDFCacheDirectory() + "/fonts.catalog"};
+  
   // Background thread for font discovery
   std::thread discoveryThread;
   std::atomic<bool> stopDiscovery{false};
-  static constexpr int DISCOVERY_INTERVAL_SECONDS = 30;
+  static constexpr int DISCOVERY_INTERVAL_SECONDS = 30;  // Rescan interval without a directory watcher
   
   // Callback for when new fonts are discovered (called from main thread context)
   std::function<void()> onFontsDiscovered;
   
 public:
   MSDFFontManager() {
+    catalog.load();
+    
     #ifdef _WIN32
     defaultSerifPath = "C:\\Windows\\Fonts\\times.ttf";
     defaultSansSerifPath = "C:\\Windows\\Fonts\\arial.ttf";
@@ -1138,6 +1475,8 @@ public:
     if (cacheThreadPool) {
       cacheThreadPool->shutdown();
     }
+    catalog.save();
+    delete registry.load(std::memory_order_acquire);
   }
   
   // Preload essential fonts from cache only (no generation - instant if cached)
@@ -1149,13 +1488,25 @@ public:
     };
     
     for (const auto& key : essentialKeys) {
-      auto it = fonts.find(key);
-      if (it != fonts.end() && it->second.isCached && !it->second.font) {
+      std::shared_ptr<FontEntry> entry;
+      {
+        std::lock_guard<std::mutex> lock(fontsMutex);
+        auto it = fonts.find(key);
+        if (it != fonts.end()) entry = it->second;
+      }
+      if (!entry) continue;
+      std::lock_guard<std::mutex> loadLock(entry->loadMutex);
+      if (entry->isCached && !entry->font) {
         // Try fast cache-only load
         auto font = std::make_unique<MSDFFont>();
-        if (font->loadFromCacheOnly(it->second.path)) {
-          it->second.font = std::move(font);
-          it->second.loadAttempted = true;
+        if (font->loadFromCacheOnly(entry->path)) {
+          entry->font = std::move(font);
+          entry->loaded.store(entry->font.get(), std::memory_order_release);
+          entry->loadAttempted = true;
+        } else {
+          // The catalog was wrong (cache deleted, or from another version)
+          entry->isCached = false;
+          catalog.setCached(entry->path, false);
         }
       }
     }
@@ -1180,7 +1531,8 @@ public:
     preloadEssentialFonts();
   }
   
-  // Start background thread that periodically scans for new fonts
+  // Start background thread that scans for new fonts, then watches the font
+  // directories for changes (or rescans them periodically, without a watcher)
   void startBackgroundDiscovery() {
     if (discoveryThread.joinable()) return;  // Already running
     
@@ -1196,6 +1548,11 @@ public:
         preCacheNewFonts(false);
       }
       
+      FontDirectoryWatcher watcher;
+      for (const auto& dir : catalog.directoryPaths()) {
+        watcher.watch(dir);
+      }
+      
       while (!stopDiscovery) {
         // Wait for thread pool to finish current batch before sleeping
         if (cacheThreadPool && cacheThreadPool->isBusy()) {
@@ -1203,22 +1560,33 @@ public:
                     << " active + " << cacheThreadPool->pendingTasks() << " pending cache tasks..." << std::endl;
           cacheThreadPool->waitForAll();
           std::cout << "MSDF: Cache generation complete" << std::endl;
+          catalog.save();
         }
         
-        // Sleep in small intervals to allow quick shutdown
-        for (int i = 0; i < DISCOVERY_INTERVAL_SECONDS && !stopDiscovery; ++i) {
-          std::this_thread::sleep_for(std::chrono::seconds(1));
+        int newFonts = 0;
+        if (watcher.available()) {
+          // Wake up each second only to allow quick shutdown
+          std::set<std::string> changed = watcher.wait(1000);
+          if (changed.empty()) continue;
+          newFonts = rescanFontDirectories(changed);
+          for (const auto& dir : catalog.directoryPaths()) {
+            watcher.watch(dir);
+          }
+        } else {
+          // Sleep in small intervals to allow quick shutdown
+          for (int i = 0; i < DISCOVERY_INTERVAL_SECONDS && !stopDiscovery; ++i) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+          }
+          if (stopDiscovery) break;
+          newFonts = scanSystemFonts();
         }
         
-        if (!stopDiscovery) {
-          int newFonts = scanSystemFonts();
-          if (newFonts > 0) {
-            std::cout << "MSDF: Discovered " << newFonts << " new fonts" << std::endl;
-            // Try GPU caching first, fall back to CPU
-            int gpuResult = generateCachesWithGPU();
-            if (gpuResult < 0) {
-              preCacheNewFonts(false);
-            }
+        if (newFonts > 0) {
+          std::cout << "MSDF: Discovered " << newFonts << " new fonts" << std::endl;
+          // Try GPU caching first, fall back to CPU
+          int gpuResult = generateCachesWithGPU();
+          if (gpuResult < 0) {
+            preCacheNewFonts(false);
           }
         }
       }
@@ -1230,8 +1598,7 @@ public:
       }
     });
     
-    std::cout << "MSDF: Started background font discovery (interval: " 
-              << DISCOVERY_INTERVAL_SECONDS << "s)" << std::endl;
+    std::cout << "MSDF: Started background font discovery" << std::endl;
   }
   
   void stopBackgroundDiscovery() {
@@ -1258,14 +1625,10 @@ public:
   void registerFontPath(const std::string& name, MSDFFontWeight weight, MSDFFontStyle style, const std::string& path) {
     std::lock_guard<std::mutex> lock(fontsMutex);
     std::string key = makeFontKey(name, weight, style);
-    
-    // Check if cache exists
-    std::string cacheDir = getMSDFCacheDirectory();
-    std::string cacheFile = cacheDir + "/" + getCacheFilename(path);
-    bool cached = std::filesystem::exists(cacheFile);
-    
-    fonts[key] = FontEntry{path, nullptr, false, cached};
+    fonts[key] = std::make_shared<FontEntry>(path, isPathCached(path));
+    allEntries.push_back(fonts[key]);
     knownFontPaths.insert(path);
+    publishRegistry();
   }
   
   // Old interface for compatibility
@@ -1292,10 +1655,17 @@ public:
         auto it = fonts.find(existingKey);
         if (it != fonts.end()) {
           std::string aliasKey = makeFontKey(lowerAlias, w, s);
-          fonts[aliasKey] = FontEntry{it->second.path, nullptr, false, it->second.isCached};
+          fonts[aliasKey] = it->second;
         }
       }
     }
+    publishRegistry();
+  }
+  
+  // Changes whenever fonts are registered, and with it what font families
+  // resolve to
+  uint64_t getGeneration() const {
+    return publishedGeneration.load(std::memory_order_acquire);
   }
   
   // Get list of all registered font families
@@ -1324,16 +1694,17 @@ public:
     size_t count = 0;
     std::set<std::string> countedPaths;
     for (const auto& pair : fonts) {
-      if (pair.second.isCached && countedPaths.find(pair.second.path) == countedPaths.end()) {
+      if (pair.second->isCached && countedPaths.find(pair.second->path) == countedPaths.end()) {
         count++;
-        countedPaths.insert(pair.second.path);
+        countedPaths.insert(pair.second->path);
       }
     }
     return count;
   }
   
 private:
-  // Scan system font directories and register discovered fonts
+  // Scan system font directories and register discovered fonts. Directories
+  // unchanged since the catalog saw them aren't read again.
   int scanSystemFonts() {
     std::vector<SystemFontInfo> discovered;
     
@@ -1351,69 +1722,117 @@ private:
     #else
     std::vector<std::string> fontDirs = {
       "/usr/share/fonts",
-      "/usr/local/share/fonts",
-      "~/.fonts",
-      "~/.local/share/fonts"
+      "/usr/local/share/fonts"
     };
+    if (const char* home = getenv("HOME")) {
+      fontDirs.push_back(std::string(home) + "/.fonts");
+      fontDirs.push_back(std::string(home) + "/.local/share/fonts");
+    }
     #endif
     
     for (const auto& dir : fontDirs) {
       scanFontDirectory(dir, discovered);
     }
     
-    // Register newly discovered fonts
+    int newCount = registerDiscoveredFonts(discovered);
+    catalog.save();
+    
+    std::cout << "MSDF: System font scan complete - found " << discovered.size() 
+              << " fonts, " << newCount << " new" << std::endl;
+    
+    return newCount;
+  }
+  
+  // Rescan directories the watcher reported changes in
+  int rescanFontDirectories(const std::set<std::string>& dirs) {
+    std::vector<SystemFontInfo> discovered;
+    for (const auto& dir : dirs) {
+      scanFontDirectory(dir, discovered, true);
+    }
+    int newCount = registerDiscoveredFonts(discovered);
+    catalog.save();
+    return newCount;
+  }
+  
+  // Register fonts not yet known, publishing them as one new registry
+  int registerDiscoveredFonts(const std::vector<SystemFontInfo>& discovered) {
     int newCount = 0;
+    std::lock_guard<std::mutex> lock(fontsMutex);
     for (const auto& info : discovered) {
-      std::lock_guard<std::mutex> lock(fontsMutex);
       if (knownFontPaths.find(info.path) == knownFontPaths.end()) {
         std::string key = makeFontKey(info.familyName, info.weight, info.style);
-        
-        // Check if cache exists
-        std::string cacheDir = getMSDFCacheDirectory();
-        std::string cacheFile = cacheDir + "/" + getCacheFilename(info.path);
-        bool cached = std::filesystem::exists(cacheFile);
-        
-        fonts[key] = FontEntry{info.path, nullptr, false, cached};
+        fonts[key] = std::make_shared<FontEntry>(info.path, isPathCached(info.path));
+        allEntries.push_back(fonts[key]);
         knownFontPaths.insert(info.path);
         newCount++;
       }
     }
+    if (newCount > 0) {
+      publishRegistry();
+    }
+    return newCount;
+  }
+  
+  // Collect the fonts in a directory tree. A directory whose mtime is the one
+  // the catalog has for it is taken from the catalog, unless changed is set
+  // (it's known to have changed); others are read.
+  void scanFontDirectory(const std::string& dirPath, std::vector<SystemFontInfo>& discovered,
+                         bool changed = false) {
+    int64_t modified;
+    uint64_t size;
+    if (!getFileStamp(dirPath, modified, size)) {
+      catalog.removeDirectory(dirPath);
+      return;
+    }
     
-    std::cout << "MSDF: System font scan complete - found " << discovered.size() 
-              << " fonts, " << newCount << " new" << std::endl;
+    std::vector<std::string> dirFonts, subdirectories;
+    if (changed || !catalog.listDirectory(dirPath, modified, dirFonts, subdirectories)) {
+      readFontDirectory(dirPath, dirFonts, subdirectories);
+      catalog.setDirectory(dirPath, modified, dirFonts, subdirectories);
+    }
     
-    return newCount;
+    for (const auto& path : dirFonts) {
+      FontCatalog::Font font;
+      if (catalog.find(path, font)) {
+        discovered.push_back(font.info);
+      }
+    }
+    for (const auto& subdirectory : subdirectories) {
+      scanFontDirectory(subdirectory, discovered);
+    }
   }
   
-  void scanFontDirectory(const std::string& dirPath, std::vector<SystemFontInfo>& discovered) {
-    try {
-      if (!std::filesystem::exists(dirPath)) return;
+  // List a directory's font files and subdirectories, adding fonts new to the
+  // catalog to it
+  void readFontDirectory(const std::string& dirPath, std::vector<std::string>& dirFonts,
+                         std::vector<std::string>& subdirectories) {
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(dirPath, error)) {
+      std::error_code typeError;
+      if (entry.is_directory(typeError)) {
+        subdirectories.push_back(entry.path().string());
+        continue;
+      }
+      if (!entry.is_regular_file(typeError)) continue;
       
-      for (const auto& entry : std::filesystem::recursive_directory_iterator(dirPath)) {
-        if (!entry.is_regular_file()) continue;
-        
-        std::string ext = entry.path().extension().string();
-        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-        
-        // Only process TrueType and OpenType fonts
-        if (ext != ".ttf" && ext != ".otf" && ext != ".ttc") continue;
-        
-        std::string fontPath = entry.path().string();
-        
-        // Skip if already known
-        {
-          std::lock_guard<std::mutex> lock(fontsMutex);
-          if (knownFontPaths.find(fontPath) != knownFontPaths.end()) continue;
-        }
-        
+      std::string ext = entry.path().extension().string();
+      std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+      
+      // Only process TrueType and OpenType fonts
+      if (ext != ".ttf" && ext != ".otf" && ext != ".ttc") continue;
+      
+      std::string fontPath = entry.path().string();
+      FontCatalog::Font font;
+      if (!catalog.find(fontPath, font) || font.info.familyName.empty()) {
         // Extract font info from filename (fast) instead of reading file
-        SystemFontInfo info = extractFontInfoFast(fontPath);
-        if (!info.familyName.empty()) {
-          discovered.push_back(info);
-        }
+        bool cached = isPathCached(fontPath);
+        font.info = extractFontInfoFast(fontPath);
+        if (font.info.familyName.empty()) continue;
+        getFileStamp(fontPath, font.modified, font.size);
+        font.cached = cached;
+        catalog.put(font);
       }
-    } catch (const std::exception& e) {
-      // Ignore directory access errors
+      dirFonts.push_back(fontPath);
     }
   }
   
@@ -1556,28 +1975,20 @@ private:
       std::lock_guard<std::mutex> cacheLock(cachingMutex);
       
       for (auto& pair : fonts) {
-        if (pair.second.isCached) continue;
-        if (pair.second.loadAttempted) continue;
+        if (pair.second->isCached) continue;
+        if (pair.second->loadAttempted) continue;
         
         // If essentialOnly, skip non-essential fonts
         if (essentialOnly && essentialKeys.find(pair.first) == essentialKeys.end()) {
           continue;
         }
         
-        const std::string& path = pair.second.path;
+        const std::string& path = pair.second->path;
         
         // Skip if already being cached or already queued
         if (pathsBeingCached.find(path) != pathsBeingCached.end()) continue;
         if (pathsToCache.find(path) != pathsToCache.end()) continue;
         
-        // Check if cache already exists
-        std::string cacheDir = getMSDFCacheDirectory();
-        std::string cacheFile = cacheDir + "/" + getCacheFilename(path);
-        if (std::filesystem::exists(cacheFile)) {
-          pair.second.isCached = true;
-          continue;
-        }
-        
         pathsToCache.insert(path);
         toCachePaths.push_back(path);
       }
@@ -1592,6 +2003,15 @@ private:
       return;
     }
     
+    // Startup waits on the essential fonts, so their glyphs are rendered on
+    // every core (split between the fonts being cached at once). Background
+    // caching keeps to one thread per font to leave the render loop alone.
+    unsigned glyphThreads = 1;
+    if (essentialOnly) {
+      unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+      glyphThreads = std::max(1u, static_cast<unsigned>(cores / cacheThreadPool->threadCount()));
+    }
+    
     std::cout << "MSDF: Queuing " << toCachePaths.size() << " fonts for parallel caching (" 
               << cacheThreadPool->threadCount() << " threads)..." << std::endl;
     
@@ -1599,7 +2019,7 @@ private:
     for (const auto& path : toCachePaths) {
       if (stopDiscovery) break;
       
-      cacheThreadPool->submit([this, path]() {
+      cacheThreadPool->submit([this, path, glyphThreads]() {
         if (stopDiscovery) {
           // Remove from being cached set
           std::lock_guard<std::mutex> cacheLock(cachingMutex);
@@ -1618,7 +2038,7 @@ private:
         // Generate cache (thread-safe, no OpenGL)
         std::cout << "MSDF: [Thread] Caching: " << std::filesystem::path(path).filename().string() << std::endl;
         auto font = std::make_unique<MSDFFont>();
-        bool success = font->generateCacheOnly(path);
+        bool success = font->generateCacheOnly(path, glyphThreads);
         
         if (success) {
           markPathAsCached(path);
@@ -1641,19 +2061,11 @@ private:
       std::set<std::string> seenPaths;
       
       for (auto& pair : fonts) {
-        if (pair.second.isCached) continue;
+        if (pair.second->isCached) continue;
         
-        const std::string& path = pair.second.path;
+        const std::string& path = pair.second->path;
         if (seenPaths.find(path) != seenPaths.end()) continue;
         
-        // Check if cache already exists
-        std::string cacheDir = getMSDFCacheDirectory();
-        std::string cacheFile = cacheDir + "/" + getCacheFilename(path);
-        if (std::filesystem::exists(cacheFile)) {
-          pair.second.isCached = true;
-          continue;
-        }
-        
         seenPaths.insert(path);
         uncachedPaths.push_back(path);
       }
@@ -1715,18 +2127,13 @@ private:
     // Regardless of exit code, check which caches were created
     // (GPU tool may partially succeed even if some fonts fail)
     int cachedCount = 0;
-    {
-      std::lock_guard<std::mutex> lock(fontsMutex);
-      for (auto& pair : fonts) {
-        if (!pair.second.isCached) {
-          std::string cacheFile = cacheDir + "/" + getCacheFilename(pair.second.path);
-          if (std::filesystem::exists(cacheFile)) {
-            pair.second.isCached = true;
-            cachedCount++;
-          }
-        }
+    for (const auto& path : uncachedPaths) {
+      if (std::filesystem::exists(cacheDir + "/" + getCacheFilename(path))) {
+        markPathAsCached(path);
+        cachedCount++;
       }
     }
+    catalog.save();
     
     if (result == 0) {
       std::cout << "MSDF: GPU caching complete (" << cachedCount << " new caches)" << std::endl;
@@ -1740,6 +2147,14 @@ private:
     return cachedCount;
   }
   
+  // Whether path has a cache file, as far as the catalog knows (checking the
+  // disk only for fonts it doesn't)
+  bool isPathCached(const std::string& path) {
+    return catalog.isCached(path, [&] {
+      return std::filesystem::exists(getMSDFCacheDirectory() + "/" + getCacheFilename(path));
+    });
+  }
+  
   // Mark a font path as cached (called from thread pool)
   void markPathAsCached(const std::string& path) {
     std::lock_guard<std::mutex> lock(fontsMutex);
@@ -1747,17 +2162,64 @@ private:
     
     // Update all font entries with this path
     for (auto& pair : fonts) {
-      if (pair.second.path == path) {
-        pair.second.isCached = true;
+      if (pair.second->path == path) {
+        pair.second->isCached = true;
       }
     }
+    catalog.setCached(path, true);
     
     pathsBeingCached.erase(path);
   }
   
-  // Internal: ensure a font entry is actually loaded (lazy load)
+  // Publish the registered fonts as a new registry snapshot, and free the
+  // replaced ones no thread is reading (fontsMutex held)
+  void publishRegistry() {
+    auto next = std::make_unique<FontRegistry>();
+    next->fonts = fonts;
+    next->generation = nextGeneration++;
+    uint64_t generation = next->generation;
+    const FontRegistry* replaced = registry.exchange(next.release(), std::memory_order_seq_cst);
+    publishedGeneration.store(generation, std::memory_order_release);
+    if (replaced) retiredRegistries.emplace_back(replaced);
+    
+    std::set<const FontRegistry*> reading;
+    {
+      std::lock_guard<std::mutex> lock(readerSlotsMutex);
+      for (const auto& slot : readerSlots) {
+        reading.insert(slot->reading.load(std::memory_order_seq_cst));
+      }
+    }
+    std::erase_if(retiredRegistries, [&](const auto& retired) { return !reading.count(retired.get()); });
+  }
+  
+  // Announce the published snapshot in this thread's reader slot and return
+  // it; it can't be freed until endRead. Publishing checks the slots after
+  // replacing the registry, and this checks the registry again after filling
+  // the slot, so one of them sees the other.
+  const FontRegistry* readRegistry(ReaderSlot& slot) const {
+    const FontRegistry* current = registry.load(std::memory_order_acquire);
+    while (true) {
+      slot.reading.store(current, std::memory_order_seq_cst);
+      const FontRegistry* again = registry.load(std::memory_order_seq_cst);
+      if (again == current) return current;
+      current = again;
+    }
+  }
+  
+  static void endRead(ReaderSlot& slot) {
+    slot.reading.store(nullptr, std::memory_order_release);
+  }
+  
+  // Internal: ensure a font entry is actually loaded (lazy load). Loaded fonts
+  // are returned without locking; loading holds the entry's own mutex.
   MSDFFont* ensureLoaded(FontEntry& entry) {
-    if (entry.font && entry.font->isLoaded()) {
+    // Failed loads are reset below, so a font here is loaded (and checking its
+    // atlas could race with the main thread uploading it)
+    if (MSDFFont* font = entry.loaded.load(std::memory_order_acquire)) {
+      return font;
+    }
+    std::lock_guard<std::mutex> lock(entry.loadMutex);
+    if (entry.font) {
       return entry.font.get();
     }
     if (entry.loadAttempted) {
@@ -1766,22 +2228,47 @@ private:
     entry.loadAttempted = true;
     entry.font = std::make_unique<MSDFFont>();
     
-    // First try fast cache-only load (no CPU generation)
-    if (entry.font->loadFromCacheOnly(entry.path)) {
-      entry.isCached = true;
-      return entry.font.get();
+    // A cache made before the font file last changed is stale
+    if (!catalog.isCurrent(entry.path)) {
+      std::error_code error;
+      std::filesystem::remove(getMSDFCacheDirectory() + "/" + getCacheFilename(entry.path), error);
+      entry.isCached = false;
     }
     
-    // Fall back to full load (may generate atlas with CPU if not cached)
-    entry.font->loadFont(entry.path);
+    // First try fast cache-only load (no CPU generation), then a full load
+    // (may generate atlas with CPU if not cached)
+    if (!entry.font->loadFromCacheOnly(entry.path)) {
+      entry.isCached = false;
+      catalog.setCached(entry.path, false);
+      entry.font->loadFont(entry.path);
+    }
     if (entry.font->isLoaded()) {
       entry.isCached = true;  // It's now cached (loadFont saves to cache)
+      catalog.setCached(entry.path, true);
+      entry.loaded.store(entry.font.get(), std::memory_order_release);
       return entry.font.get();
     }
     entry.font.reset();
     return nullptr;
   }
   
+  // Fonts resolved by one thread against one registry generation, by
+  // font-family value - so repeated lookups of the same style neither lock
+  // nor parse the family list
+  struct ResolvedFonts {
+    struct Hash {
+      using is_transparent = void;
+      size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+    uint64_t generation = 0;
+    std::unordered_map<std::string, MSDFFont*, Hash, std::equal_to<>> byFamily[2][2];  // [bold][italic]
+  };
+  
+  static ResolvedFonts& resolvedFonts() {
+    thread_local ResolvedFonts resolved;
+    return resolved;
+  }
+  
 public:
   // Convert from old Font.hpp enum types
   MSDFFont* getFont(const std::string& fontFamily, int fontWeight = 0, int fontStyle = 0) {
@@ -1790,58 +2277,75 @@ public:
     return getFontInternal(fontFamily, w, s);
   }
   
+  // Lock-free: what this thread resolved against the published generation
+  // before, else the published registry
   MSDFFont* getFontInternal(const std::string& fontFamily, MSDFFontWeight weight, MSDFFontStyle style) {
-    std::lock_guard<std::mutex> lock(fontsMutex);
-    std::vector<std::string> families = parseFontFamily(fontFamily);
+    ResolvedFonts& resolved = resolvedFonts();
+    bool bold = weight == MSDFFontWeight::Bold || weight == MSDFFontWeight::Bolder;
+    bool italic = style == MSDFFontStyle::Italic || style == MSDFFontStyle::Oblique;
+    auto& families = resolved.byFamily[bold][italic];
+    if (resolved.generation == publishedGeneration.load(std::memory_order_acquire)) {
+      auto it = families.find(std::string_view(fontFamily));
+      if (it != families.end()) return it->second;
+    }
+    
+    ReaderSlot& slot = readerSlot();
+    const FontRegistry* current = readRegistry(slot);
+    if (!current) {
+      endRead(slot);
+      return nullptr;
+    }
+    if (resolved.generation != current->generation) {
+      for (auto& byStyle : resolved.byFamily) {
+        for (auto& cleared : byStyle) cleared.clear();
+      }
+      resolved.generation = current->generation;
+    }
+    MSDFFont* font = resolveFont(*current, fontFamily, weight, style);
+    endRead(slot);
+    families.emplace(fontFamily, font);
+    return font;
+  }
+  
+  MSDFFont* getDefaultFont() {
+    return getFont("serif");
+  }
+
+private:
+  // Walk a font-family list (then serif, then anything) to the first font
+  // that loads
+  MSDFFont* resolveFont(const FontRegistry& current, const std::string& fontFamily,
+                        MSDFFontWeight weight, MSDFFontStyle style) {
+    auto loadKey = [&](const std::string& key) -> MSDFFont* {
+      auto it = current.fonts.find(key);
+      return it != current.fonts.end() ? ensureLoaded(*it->second) : nullptr;
+    };
     
+    std::vector<std::string> families = parseFontFamily(fontFamily);
     for (const auto& family : families) {
-      std::string key = makeFontKey(family, weight, style);
-      auto it = fonts.find(key);
-      if (it != fonts.end()) {
-        MSDFFont* font = ensureLoaded(it->second);
-        if (font) return font;
-      }
+      if (MSDFFont* font = loadKey(makeFontKey(family, weight, style))) return font;
       
       // Fallback without italic
       if (style != MSDFFontStyle::Normal) {
-        key = makeFontKey(family, weight, MSDFFontStyle::Normal);
-        it = fonts.find(key);
-        if (it != fonts.end()) {
-          MSDFFont* font = ensureLoaded(it->second);
-          if (font) return font;
-        }
+        if (MSDFFont* font = loadKey(makeFontKey(family, weight, MSDFFontStyle::Normal))) return font;
       }
       
       // Fallback to regular
-      key = makeFontKey(family, MSDFFontWeight::Normal, MSDFFontStyle::Normal);
-      it = fonts.find(key);
-      if (it != fonts.end()) {
-        MSDFFont* font = ensureLoaded(it->second);
-        if (font) return font;
-      }
+      if (MSDFFont* font = loadKey(makeFontKey(family, MSDFFontWeight::Normal, MSDFFontStyle::Normal))) return font;
     }
     
     // Fallback to serif
-    std::string key = makeFontKey("serif", MSDFFontWeight::Normal, MSDFFontStyle::Normal);
-    auto it = fonts.find(key);
-    if (it != fonts.end()) {
-      MSDFFont* font = ensureLoaded(it->second);
-      if (font) return font;
-    }
+    if (MSDFFont* font = loadKey(makeFontKey("serif", MSDFFontWeight::Normal, MSDFFontStyle::Normal))) return font;
     
     // Last resort: try any registered font
-    for (auto& pair : fonts) {
-      MSDFFont* font = ensureLoaded(pair.second);
+    for (const auto& pair : current.fonts) {
+      MSDFFont* font = ensureLoaded(*pair.second);
       if (font) return font;
     }
     
     return nullptr;
   }
   
-  MSDFFont* getDefaultFont() {
-    return getFont("serif");
-  }
-
 private:
   std::string toLower(const std::string& str) const {
     std::string result = str;
@@ -121,6 +121,15 @@ class Renderer {
   std::vector<ColorVertex> rectBatch;
   bool batchingEnabled = true;
   
+  // MSDF glyph quads of the text being drawn, and the font texture page each
+  // one samples (see MSDFFont::DrawGlyph)
+  struct GlyphQuad {
+    int page;
+    float x0, y0, x1, y1;
+    float u0, v0, u1, v1;
+  };
+  std::vector<GlyphQuad> glyphQuads;
+  
   // MSDF shader program
   GLuint msdfShaderProgram = 0;
   GLint msdfUniformTex = -1;
@@ -180,7 +189,9 @@ public:
   
   float getTranslateY() const { return translateY; }
 
+  // Start a frame
   void clear() {
+    MSDFFont::beginFrame();
     glDisable(GL_DEPTH_TEST);
     glDisable(GL_CULL_FACE);
     glDisable(GL_TEXTURE_2D);
@@ -725,42 +736,11 @@ public:
     
     glEnable(GL_TEXTURE_2D);
     if (glActiveTexture_ptr) glActiveTexture_ptr(GL_TEXTURE0);
-    font.bind();
     
-    glBegin(GL_QUADS);
-    float currentX = 0;
-    size_t charIndex = 0;
-    
-    for (size_t i = 0; i < text.length(); ++i) {
-      int cp = MSDFFont::decodeUTF8(text, i);
-      if (cp < 32) {
-        charIndex++;
-        continue;
-      }
-      
-      const MSDFGlyph* glyph = font.getGlyph(cp);
-      if (!glyph || !glyph->valid) {
-        charIndex++;
-        continue;
-      }
-      
-      // Only draw if within the specified range
-      if (charIndex >= startIdx && charIndex < endIdx && glyph->width > 0) {
-        float x0 = snappedX + currentX + glyph->xoff * scale;
-        float y0 = snappedY + glyph->yoff * scale;
-        float x1 = x0 + glyph->width * scale;
-        float y1 = y0 + glyph->height * scale;
-        
-        glTexCoord2f(glyph->u0, glyph->v0); glVertex2f(x0, y0);
-        glTexCoord2f(glyph->u1, glyph->v0); glVertex2f(x1, y0);
-        glTexCoord2f(glyph->u1, glyph->v1); glVertex2f(x1, y1);
-        glTexCoord2f(glyph->u0, glyph->v1); glVertex2f(x0, y1);
-      }
-      
-      currentX += glyph->advance * scale;
-      charIndex++;
-    }
-    glEnd();
+    // Only draw characters within the specified range
+    collectGlyphQuads(snappedX, snappedY, text, font, scale,
+                      [&](size_t charIndex) { return charIndex >= startIdx && charIndex < endIdx; });
+    drawGlyphQuads(font);
     
     glDisable(GL_TEXTURE_2D);
     glUseProgram(0);
@@ -797,89 +777,80 @@ public:
     
     glEnable(GL_TEXTURE_2D);
     if (glActiveTexture_ptr) glActiveTexture_ptr(GL_TEXTURE0);
-    font.bind();
     
     // First pass: draw non-selected characters
     glUniform4f(msdfUniformColor, r, g, b, a * globalOpacity);
-    glBegin(GL_QUADS);
+    collectGlyphQuads(snappedX, snappedY, text, font, scale,
+                      [&](size_t charIndex) { return !(charIndex >= selStart && charIndex < selEnd); });
+    drawGlyphQuads(font);
+    
+    // Second pass: draw selected characters with selection color
+    if (selStart < selEnd) {
+      glUniform4f(msdfUniformColor, selR, selG, selB, selA * globalOpacity);
+      collectGlyphQuads(snappedX, snappedY, text, font, scale,
+                        [&](size_t charIndex) { return charIndex >= selStart && charIndex < selEnd; });
+      drawGlyphQuads(font);
+    }
+    
+    glDisable(GL_TEXTURE_2D);
+    glUseProgram(0);
+  }
+
+private:
+  // Lay out text's glyphs from the baseline at (x, y) into glyphQuads, keeping
+  // the characters include(charIndex) accepts. Glyphs still being rendered
+  // take up their advance but aren't drawn yet.
+  template <typename Include>
+  void collectGlyphQuads(float x, float y, const std::string &text, MSDFFont &font,
+                         float scale, Include include) {
+    glyphQuads.clear();
     float currentX = 0;
     size_t charIndex = 0;
+    MSDFFont::DrawGlyph drawGlyph;
     
     for (size_t i = 0; i < text.length(); ++i) {
       int cp = MSDFFont::decodeUTF8(text, i);
-      if (cp < 32) {
+      if (cp < 32 || !font.getDrawGlyph(cp, drawGlyph)) {
         charIndex++;
         continue;
       }
       
-      const MSDFGlyph* glyph = font.getGlyph(cp);
-      if (!glyph || !glyph->valid) {
-        charIndex++;
-        continue;
-      }
-      
-      // Only draw non-selected characters in first pass
-      if (glyph->width > 0 && !(charIndex >= selStart && charIndex < selEnd)) {
-        float x0 = snappedX + currentX + glyph->xoff * scale;
-        float y0 = snappedY + glyph->yoff * scale;
-        float x1 = x0 + glyph->width * scale;
-        float y1 = y0 + glyph->height * scale;
-        
-        glTexCoord2f(glyph->u0, glyph->v0); glVertex2f(x0, y0);
-        glTexCoord2f(glyph->u1, glyph->v0); glVertex2f(x1, y0);
-        glTexCoord2f(glyph->u1, glyph->v1); glVertex2f(x1, y1);
-        glTexCoord2f(glyph->u0, glyph->v1); glVertex2f(x0, y1);
+      const MSDFGlyph &glyph = drawGlyph.glyph;
+      if (glyph.valid && glyph.width > 0 && include(charIndex)) {
+        float x0 = x + currentX + glyph.xoff * scale;
+        float y0 = y + glyph.yoff * scale;
+        glyphQuads.push_back({drawGlyph.page, x0, y0, x0 + glyph.width * scale, y0 + glyph.height * scale,
+                              glyph.u0, glyph.v0, glyph.u1, glyph.v1});
       }
       
-      currentX += glyph->advance * scale;
+      currentX += glyph.advance * scale;
       charIndex++;
     }
-    glEnd();
-    
-    // Second pass: draw selected characters with selection color
-    if (selStart < selEnd) {
-      glUniform4f(msdfUniformColor, selR, selG, selB, selA * globalOpacity);
+  }
+  
+  // Draw glyphQuads, one batch per font texture page
+  void drawGlyphQuads(MSDFFont &font) {
+    if (glyphQuads.empty()) return;
+    std::stable_sort(glyphQuads.begin(), glyphQuads.end(),
+                     [](const GlyphQuad &a, const GlyphQuad &b) { return a.page < b.page; });
+    
+    for (size_t start = 0; start < glyphQuads.size();) {
+      int page = glyphQuads[start].page;
+      font.bindPage(page);
       glBegin(GL_QUADS);
-      currentX = 0;
-      charIndex = 0;
-      
-      for (size_t i = 0; i < text.length(); ++i) {
-        int cp = MSDFFont::decodeUTF8(text, i);
-        if (cp < 32) {
-          charIndex++;
-          continue;
-        }
-        
-        const MSDFGlyph* glyph = font.getGlyph(cp);
-        if (!glyph || !glyph->valid) {
-          charIndex++;
-          continue;
-        }
-        
-        // Only draw selected characters in second pass
-        if (glyph->width > 0 && (charIndex >= selStart && charIndex < selEnd)) {
-          float x0 = snappedX + currentX + glyph->xoff * scale;
-          float y0 = snappedY + glyph->yoff * scale;
-          float x1 = x0 + glyph->width * scale;
-          float y1 = y0 + glyph->height * scale;
-          
-          glTexCoord2f(glyph->u0, glyph->v0); glVertex2f(x0, y0);
-          glTexCoord2f(glyph->u1, glyph->v0); glVertex2f(x1, y0);
-          glTexCoord2f(glyph->u1, glyph->v1); glVertex2f(x1, y1);
-          glTexCoord2f(glyph->u0, glyph->v1); glVertex2f(x0, y1);
-        }
-        
-        currentX += glyph->advance * scale;
-        charIndex++;
+      size_t i = start;
+      for (; i < glyphQuads.size() && glyphQuads[i].page == page; ++i) {
+        const GlyphQuad &q = glyphQuads[i];
+        glTexCoord2f(q.u0, q.v0); glVertex2f(q.x0, q.y0);
+        glTexCoord2f(q.u1, q.v0); glVertex2f(q.x1, q.y0);
+        glTexCoord2f(q.u1, q.v1); glVertex2f(q.x1, q.y1);
+        glTexCoord2f(q.u0, q.v1); glVertex2f(q.x0, q.y1);
       }
       glEnd();
+      start = i;
     }
-    
-    glDisable(GL_TEXTURE_2D);
-    glUseProgram(0);
   }
 
-private:
   void initMSDFShader() {
     // Load OpenGL 2.0+ functions
     if (!loadGLFunctions()) {
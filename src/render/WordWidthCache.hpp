@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace skene {
+
+// Widths of words already measured in one font. Text layout measures every
+// word on every rewrap, and the same words recur across a document and across
+// resizes. Widths are linear in font size, so entries hold the width at the
+// atlas glyph size and serve every size.
+//
+// Most words aren't cached at all: GlyphTable::measure sums a short word, or
+// an ASCII word of moderate length, faster than it can be hashed and looked up
+// (see tools/glyph-bench), so callers measure those themselves and only come
+// here for words worthCaching() picks. Longer words with other characters are
+// decoded one by one, and very long ASCII words (URLs) take a while to sum, so
+// those are cached. Each thread that lays out (the main thread and the layout worker)
+// has its own direct-mapped table per font, so lookups take no locks and a
+// colliding word just replaces the one before it.
+class WordWidthCache {
+public:
+  static constexpr size_t SLOT_COUNT = 1024;        // Per font, per thread
+  static constexpr size_t MIN_WORD_LENGTH = 16;     // Shorter words aren't cached
+  static constexpr size_t LONG_ASCII_WORD = 48;     // Nor ASCII words shorter than this
+  static constexpr size_t MAX_WORD_LENGTH = 128;    // Nor longer words
+
+  WordWidthCache() = default;
+  WordWidthCache(const WordWidthCache &) = delete;
+  WordWidthCache &operator=(const WordWidthCache &) = delete;
+
+  // Lookups so far, and how many were answered from a table, across fonts and
+  // threads. Only words worth caching are looked up.
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t lookups = 0;
+
+    double hitRate() const { return lookups ? static_cast<double>(hits) / lookups : 0.0; }
+  };
+
+  static Stats stats() {
+    Stats total;
+    std::lock_guard<std::mutex> lock(countersMutex);
+    for (const auto &counters : allCounters) {
+      uint64_t hits = counters->hits.load(std::memory_order_relaxed);
+      total.hits += hits;
+      total.lookups += hits + counters->misses.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  // True for words that take longer to measure than to look up: long enough,
+  // and not plain ASCII unless they're very long
+  static bool worthCaching(std::string_view word) {
+    return word.size() >= MIN_WORD_LENGTH && word.size() <= MAX_WORD_LENGTH &&
+           (word.size() >= LONG_ASCII_WORD || !isAscii(word));
+  }
+
+  // The width of a word worth caching: measure(word), or what it gave last time
+  template <typename Measure>
+  float get(std::string_view word, Measure &&measure) {
+    size_t hash = std::hash<std::string_view>{}(word);
+    Slot &slot = table()[hash & (SLOT_COUNT - 1)];
+    Counters &counters = threadCounters();
+    if (slot.hash == hash && slot.word == word) {
+      counters.add(counters.hits);
+      return slot.width;
+    }
+    counters.add(counters.misses);
+    float width = measure(word);
+    slot.hash = hash;
+    slot.word.assign(word);
+    slot.width = width;
+    return width;
+  }
+
+private:
+  struct Slot {
+    size_t hash = 0;
+    std::string word;
+    float width = 0;
+  };
+
+  // Written only by their thread, read by hitRate() from any
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+
+    void add(std::atomic<uint64_t> &counter) {
+      counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+  };
+
+  // This thread's tables, by cache id. Ids aren't reused, so a table left by a
+  // destroyed cache is never read again.
+  struct ThreadTables {
+    uint64_t lastId = 0;
+    Slot *last = nullptr;
+    std::unordered_map<uint64_t, std::unique_ptr<Slot[]>> tables;
+  };
+
+  static bool isAscii(std::string_view word) {
+    unsigned char bits = 0;
+    for (char c : word) bits |= static_cast<unsigned char>(c);
+    return bits < 0x80;
+  }
+
+  Slot *table() {
+    thread_local ThreadTables local;
+    if (local.lastId == id) return local.last;
+    auto &slots = local.tables[id];
+    if (!slots) slots = std::make_unique<Slot[]>(SLOT_COUNT);
+    local.lastId = id;
+    local.last = slots.get();
+    return local.last;
+  }
+
+  static Counters &threadCounters() {
+    thread_local std::shared_ptr<Counters> counters = [] {
+      auto created = std::make_shared<Counters>();
+      std::lock_guard<std::mutex> lock(countersMutex);
+      allCounters.push_back(created);
+      return created;
+    }();
+    return *counters;
+  }
+
+  static inline std::atomic<uint64_t> nextId{1};
+  static inline std::mutex countersMutex;
+  static inline std::vector<std::shared_ptr<Counters>> allCounters;
+
+  const uint64_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+};
+
+} // namespace skene
@@ -14,12 +14,15 @@
 #include "Color.hpp"
 #include "CssParser.hpp"
 #include "dom/Node.hpp"
+#include <cstdint>
 #include <map>
 #include <string>
 #include <sstream>
 
 namespace skene {
 
+class MSDFFont;
+
 // Font style enums (CSS values)
 enum class FontWeight { Normal, Bold, Lighter, Bolder };
 enum class FontStyle { Normal, Italic, Oblique };
@@ -38,6 +41,14 @@ enum class Position { Static, Relative, Absolute, Fixed, Sticky };
 
 enum class BoxSizing { ContentBox, BorderBox };
 
+enum class TableLayout { Auto, Fixed };
+
+enum class ContentVisibility { Visible, Auto, Hidden };
+
+enum class FlexDirection { Row, RowReverse, Column, ColumnReverse };
+
+enum class FlexWrap { NoWrap, Wrap, WrapReverse };
+
 enum class ListStyleType { None, Disc, Circle, Square, Decimal, DecimalLeadingZero, LowerAlpha, UpperAlpha, LowerRoman, UpperRoman };
 
 struct EdgeValues {
@@ -94,11 +105,31 @@ public:
     TextAlign textAlign = TextAlign::Left;
     std::string fontFamily = "serif";  // Default browser font (Times New Roman)
 
+    // The face fontFamily/fontWeight/fontStyle resolve to, fallbacks walked:
+    // filled in on first use (see fontForStyle) and kept until the font
+    // registry's generation moves on. Code changing the font properties
+    // copies it along with them (inheritFont) or clears it.
+    struct ResolvedFont {
+      MSDFFont *font = nullptr;
+      uint64_t generation = 0;
+    };
+    mutable ResolvedFont resolvedFont;
+
     // Layout
     DisplayType display = DisplayType::Block;
     Position position = Position::Static;
     BoxSizing boxSizing = BoxSizing::ContentBox;
     Overflow overflow = Overflow::Visible;
+    TableLayout tableLayout = TableLayout::Auto;
+
+    // Containment (contain / content-visibility)
+    bool containSize = false;    // Size ignores descendants (uses contain-intrinsic-size)
+    bool containLayout = false;  // Descendant layout can't affect the outside
+    bool containPaint = false;   // Descendants are clipped to the padding box
+    ContentVisibility contentVisibility = ContentVisibility::Visible;
+    CssValue containIntrinsicWidth{-1, CssUnit::Auto};
+    CssValue containIntrinsicHeight{-1, CssUnit::Auto};
+    bool containIntrinsicSizeAuto = false;  // "auto <length>": prefer last laid-out size
 
     // Positioning
     CssValue top{0, CssUnit::Auto};
@@ -106,6 +137,7 @@ public:
     CssValue bottom{0, CssUnit::Auto};
     CssValue left{0, CssUnit::Auto};
     int zIndex = 0;
+    bool zIndexAuto = true;  // z-index: auto (no stacking context of its own)
 
     // Border radius
     float borderRadius = 0.0f;
@@ -118,8 +150,8 @@ public:
     float opacity = 1.0f;
 
     // Flexbox
-    std::string flexDirection = "row";
-    std::string flexWrap = "nowrap";  // nowrap, wrap, wrap-reverse
+    FlexDirection flexDirection = FlexDirection::Row;
+    FlexWrap flexWrap = FlexWrap::NoWrap;
     std::string justifyContent = "flex-start";
     std::string alignItems = "stretch";
     float flexGrow = 0.0f;
@@ -142,6 +174,14 @@ public:
     // Vertical alignment for inline elements
     std::string verticalAlign = "baseline";  // baseline, top, middle, bottom, text-top, text-bottom, sub, super
 
+    // Take another style's font properties, with the face they resolved to
+    void inheritFont(const ComputedStyle &from) {
+      fontWeight = from.fontWeight;
+      fontStyle = from.fontStyle;
+      fontFamily = from.fontFamily;
+      resolvedFont = from.resolvedFont;
+    }
+
     // Helper to get total padding in pixels
     float getPaddingTop(float parentWidth = 0, float fontSize = 16.0f) const {
       return padding.top.toPx(parentWidth, fontSize);
@@ -640,6 +680,71 @@ private:
       } else {
         style.overflow = Overflow::Visible;
       }
+    } else if (property == "table-layout") {
+      std::string v = CssParser::trim(value);
+      if (v == "fixed") {
+        style.tableLayout = TableLayout::Fixed;
+      } else {
+        style.tableLayout = TableLayout::Auto;
+      }
+    } else if (property == "contain") {
+      std::string v = CssParser::trim(value);
+      style.containSize = style.containLayout = style.containPaint = false;
+      if (v == "strict") {
+        style.containSize = style.containLayout = style.containPaint = true;
+      } else if (v == "content") {
+        style.containLayout = style.containPaint = true;
+      } else {
+        std::istringstream iss(v);
+        std::string token;
+        while (iss >> token) {
+          if (token == "size") style.containSize = true;
+          else if (token == "layout") style.containLayout = true;
+          else if (token == "paint") style.containPaint = true;
+        }
+      }
+    } else if (property == "content-visibility") {
+      std::string v = CssParser::trim(value);
+      if (v == "auto") {
+        style.contentVisibility = ContentVisibility::Auto;
+      } else if (v == "hidden") {
+        style.contentVisibility = ContentVisibility::Hidden;
+      } else {
+        style.contentVisibility = ContentVisibility::Visible;
+      }
+    } else if (property == "contain-intrinsic-size") {
+      // contain-intrinsic-size: [auto] <width> [[auto] <height>]
+      std::istringstream iss(CssParser::trim(value));
+      std::string token;
+      std::vector<CssValue> sizes;
+      style.containIntrinsicSizeAuto = false;
+      while (iss >> token) {
+        if (token == "auto") {
+          style.containIntrinsicSizeAuto = true;
+        } else if (token == "none") {
+          sizes.push_back(CssValue{-1, CssUnit::Auto});
+        } else {
+          sizes.push_back(CssParser::parseValue(token));
+        }
+      }
+      if (!sizes.empty()) {
+        style.containIntrinsicWidth = sizes[0];
+        style.containIntrinsicHeight = sizes.size() > 1 ? sizes[1] : sizes[0];
+      }
+    } else if (property == "contain-intrinsic-width") {
+      std::string v = CssParser::trim(value);
+      if (v.rfind("auto ", 0) == 0) {
+        style.containIntrinsicSizeAuto = true;
+        v = CssParser::trim(v.substr(5));
+      }
+      style.containIntrinsicWidth = v == "none" ? CssValue{-1, CssUnit::Auto} : CssParser::parseValue(v);
+    } else if (property == "contain-intrinsic-height") {
+      std::string v = CssParser::trim(value);
+      if (v.rfind("auto ", 0) == 0) {
+        style.containIntrinsicSizeAuto = true;
+        v = CssParser::trim(v.substr(5));
+      }
+      style.containIntrinsicHeight = v == "none" ? CssValue{-1, CssUnit::Auto} : CssParser::parseValue(v);
     }
     // Positioning
     else if (property == "top") {
@@ -651,7 +756,17 @@ private:
     } else if (property == "left") {
       style.left = CssParser::parseValue(value);
     } else if (property == "z-index") {
-      style.zIndex = std::stoi(CssParser::trim(value));
+      std::string v = CssParser::trim(value);
+      if (v == "auto") {
+        style.zIndex = 0;
+        style.zIndexAuto = true;
+      } else {
+        try {
+          style.zIndex = std::stoi(v);
+          style.zIndexAuto = false;
+        } catch (...) {
+        }
+      }
     }
     // Opacity
     else if (property == "opacity") {
@@ -659,9 +774,25 @@ private:
     }
     // Flexbox
     else if (property == "flex-direction") {
-      style.flexDirection = CssParser::trim(value);
+      std::string v = CssParser::trim(value);
+      if (v == "row-reverse") {
+        style.flexDirection = FlexDirection::RowReverse;
+      } else if (v == "column") {
+        style.flexDirection = FlexDirection::Column;
+      } else if (v == "column-reverse") {
+        style.flexDirection = FlexDirection::ColumnReverse;
+      } else {
+        style.flexDirection = FlexDirection::Row;
+      }
     } else if (property == "flex-wrap") {
-      style.flexWrap = CssParser::trim(value);
+      std::string v = CssParser::trim(value);
+      if (v == "wrap") {
+        style.flexWrap = FlexWrap::Wrap;
+      } else if (v == "wrap-reverse") {
+        style.flexWrap = FlexWrap::WrapReverse;
+      } else {
+        style.flexWrap = FlexWrap::NoWrap;
+      }
     } else if (property == "justify-content") {
       style.justifyContent = CssParser::trim(value);
     } else if (property == "align-items") {
@@ -0,0 +1,273 @@
+/*
+ * glyph-bench: Text measurement microbenchmark for the glyph table
+ *
+ * Measures UTF-8 text the way MSDFFont::getTextWidth has done it - decoding
+ * each character and looking its glyph up in a std::map, then in the
+ * GlyphTable - and with GlyphTable::measure's ASCII fast path, and reports the
+ * time per character of each, for mixed text and for long ASCII lines. Then
+ * measures the same text a word at a time, as layout does, directly and
+ * through WordWidthCache, to show what the cache saves.
+ *
+ * Usage: glyph-bench [iterations]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "render/GlyphTable.hpp"
+#include "render/WordWidthCache.hpp"
+
+using namespace skene;
+
+//=============================================================================
+// Glyph set - the same codepoints MSDFFont::getCharacterSet builds atlases for
+//=============================================================================
+
+static std::vector<int> characterSet() {
+  std::vector<int> chars;
+  for (int c = 32; c <= 126; c++) chars.push_back(c);
+  for (int c = 160; c <= 255; c++) chars.push_back(c);
+  for (int c : {0x20AC, 0x2019, 0x201C, 0x201D, 0x2022, 0x2026, 0x2013, 0x2014, 0x2122}) {
+    chars.push_back(c);
+  }
+  return chars;
+}
+
+static MSDFGlyph syntheticGlyph(int codepoint) {
+  MSDFGlyph glyph{};
+  glyph.advance = 8.0f + static_cast<float>(codepoint % 13);
+  glyph.width = glyph.advance - 1.0f;
+  glyph.height = 24.0f;
+  glyph.valid = codepoint != 0xAD;  // Soft hyphen has no outline
+  return glyph;
+}
+
+//=============================================================================
+// Measurement - mirrors MSDFFont::getTextWidth before and after the table
+//=============================================================================
+
+static float widthWithMap(const std::map<int, MSDFGlyph> &glyphs, const std::string &text, float scale) {
+  float width = 0;
+  for (size_t i = 0; i < text.length(); ++i) {
+    int cp = decodeUTF8(text, i);
+    if (cp < 32) continue;
+    auto it = glyphs.find(cp);
+    if (it != glyphs.end() && it->second.valid) {
+      width += it->second.advance * scale;
+    }
+  }
+  return width;
+}
+
+static float widthWithTable(const GlyphTable &glyphs, const std::string &text, float scale) {
+  float width = 0;
+  for (size_t i = 0; i < text.length(); ++i) {
+    int cp = decodeUTF8(text, i);
+    if (cp < 32) continue;
+    width += glyphs.advance(cp) * scale;
+  }
+  return width;
+}
+
+static float widthWithMeasure(const GlyphTable &glyphs, const std::string &text, float scale) {
+  return glyphs.measure(text, scale);
+}
+
+//=============================================================================
+// Corpus
+//=============================================================================
+
+// Lines of 12 words; asciiPercent of the words are plain ASCII
+static std::vector<std::string> corpus(unsigned asciiPercent) {
+  const char *words[] = {
+    "the", "layout", "engine", "measures", "every", "word", "of", "text",
+    "café", "naïve", "façade", "Zürich", "déjà", "vu", "—", "“quoted”",
+    "it’s", "€12", "•", "…", "™", "Привет", "日本語", "\xE2\x80\x8B",
+  };
+  std::vector<std::string> lines;
+  unsigned seed = 12345;
+  for (int line = 0; line < 2000; line++) {
+    std::string text;
+    for (int w = 0; w < 12; w++) {
+      seed = seed * 1103515245 + 12345;
+      unsigned pick = (seed >> 16) % 100;
+      size_t index = pick < asciiPercent ? pick % 8 : 8 + pick % 16;
+      if (!text.empty()) text += ' ';
+      text += words[index];
+    }
+    lines.push_back(std::move(text));
+  }
+  return lines;
+}
+
+template <typename Measure>
+static double nanosPerChar(const std::vector<std::string> &lines, size_t chars, int iterations,
+                           double &checksum, Measure measure) {
+  auto start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; it++) {
+    for (const auto &line : lines) checksum += measure(line);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double nanos = std::chrono::duration<double, std::nano>(elapsed).count();
+  return nanos / (static_cast<double>(chars) * iterations);
+}
+
+static bool run(const char *name, const std::vector<std::string> &lines, int iterations,
+                const std::map<int, MSDFGlyph> &map, const GlyphTable &table) {
+  const float scale = 16.0f / 32.0f;
+  size_t chars = 0;
+  for (const auto &line : lines) {
+    for (size_t i = 0; i < line.length(); ++i) {
+      decodeUTF8(line, i);
+      chars++;
+    }
+  }
+
+  // The table must give the map's widths exactly; measure() sums in a
+  // different order, so only to within rounding
+  for (const auto &line : lines) {
+    float expected = widthWithMap(map, line, scale);
+    float measured = widthWithMeasure(table, line, scale);
+    if (widthWithTable(table, line, scale) != expected ||
+        std::fabs(measured - expected) > expected * 1e-5f) {
+      std::cerr << "Widths differ on: " << line << std::endl;
+      return false;
+    }
+  }
+
+  double checksum = 0;
+  double mapNs = nanosPerChar(lines, chars, iterations, checksum,
+                              [&](const std::string &s) { return widthWithMap(map, s, scale); });
+  double tableNs = nanosPerChar(lines, chars, iterations, checksum,
+                                [&](const std::string &s) { return widthWithTable(table, s, scale); });
+  double measureNs = nanosPerChar(lines, chars, iterations, checksum,
+                                  [&](const std::string &s) { return widthWithMeasure(table, s, scale); });
+
+  std::cout << name << ": " << lines.size() << " lines, " << chars << " characters" << std::endl;
+  std::cout << "  std::map lookup:      " << mapNs << " ns/char" << std::endl;
+  std::cout << "  GlyphTable lookup:    " << tableNs << " ns/char (" << mapNs / tableNs << "x)" << std::endl;
+  std::cout << "  GlyphTable::measure:  " << measureNs << " ns/char (" << mapNs / measureNs << "x)" << std::endl;
+  std::cout << "  (checksum " << checksum << ")" << std::endl;
+  return true;
+}
+
+//=============================================================================
+// Words - mirrors MSDFFont::getWordWidth against measuring each word
+//=============================================================================
+
+static std::vector<std::string_view> splitWords(const std::vector<std::string> &lines) {
+  std::vector<std::string_view> words;
+  for (const auto &line : lines) {
+    std::string_view text(line);
+    size_t start = 0;
+    while (start < text.size()) {
+      size_t end = text.find(' ', start);
+      if (end == std::string_view::npos) end = text.size();
+      if (end > start) words.push_back(text.substr(start, end - start));
+      start = end + 1;
+    }
+  }
+  return words;
+}
+
+template <typename Measure>
+static double nanosPerWord(const std::vector<std::string_view> &words, int iterations, double &checksum,
+                           Measure measure) {
+  auto start = std::chrono::steady_clock::now();
+  for (int it = 0; it < iterations; it++) {
+    for (std::string_view word : words) checksum += measure(word);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double nanos = std::chrono::duration<double, std::nano>(elapsed).count();
+  return nanos / (static_cast<double>(words.size()) * iterations);
+}
+
+// Words long enough to be cached: long non-ASCII words, and URLs
+static std::vector<std::string> longWords() {
+  const char *words[] = {
+    "достопримечательность", "характеристика", "Größenverhältnisse",
+    "Donaudampfschifffahrtsgesellschaftskapitän", "Unabhängigkeitserklärung",
+    "https://example.com/articles/2024/layout-engine-text-measurement.html",
+    "https://en.wikipedia.org/wiki/Multi-channel_signed_distance_field",
+    "internationalization", "counterrevolutionaries",
+  };
+  std::vector<std::string> lines;
+  unsigned seed = 54321;
+  for (int line = 0; line < 2000; line++) {
+    std::string text;
+    for (int w = 0; w < 12; w++) {
+      seed = seed * 1103515245 + 12345;
+      if (!text.empty()) text += ' ';
+      text += words[(seed >> 16) % 9];
+    }
+    lines.push_back(std::move(text));
+  }
+  return lines;
+}
+
+static bool runWords(const char *name, const std::vector<std::string> &lines, int iterations,
+                     const GlyphTable &table) {
+  std::vector<std::string_view> words = splitWords(lines);
+  WordWidthCache cache;
+  auto direct = [&](std::string_view word) { return table.measure(word, 1.0f); };
+  auto lookUp = [&](std::string_view word) { return cache.get(word, direct); };
+  auto cached = [&](std::string_view word) {
+    if (WordWidthCache::worthCaching(word)) return lookUp(word);
+    return direct(word);
+  };
+
+  // Cached widths must be the measured ones; this pass also fills the cache
+  for (std::string_view word : words) {
+    if (cached(word) != direct(word)) {
+      std::cerr << "Cached width differs for: " << word << std::endl;
+      return false;
+    }
+  }
+
+  // Alternate the two and keep each one's best round, so neither gains from
+  // running first or second
+  double checksum = 0;
+  double directNs = 1e300, cachedNs = 1e300;
+  for (int round = 0; round < 5; round++) {
+    directNs = std::min(directNs, nanosPerWord(words, iterations, checksum, direct));
+    cachedNs = std::min(cachedNs, nanosPerWord(words, iterations, checksum, cached));
+  }
+
+  std::cout << name << ": " << words.size() << " words" << std::endl;
+  std::cout << "  GlyphTable::measure:  " << directNs << " ns/word" << std::endl;
+  std::cout << "  getWordWidth's way:   " << cachedNs << " ns/word (" << directNs / cachedNs << "x)"
+            << std::endl;
+  std::cout << "  (checksum " << checksum << ")" << std::endl;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+  if (iterations <= 0) iterations = 200;
+
+  std::map<int, MSDFGlyph> map;
+  GlyphTable table;
+  for (int cp : characterSet()) {
+    map[cp] = syntheticGlyph(cp);
+    table.set(cp, syntheticGlyph(cp));
+  }
+  std::cout << "Glyphs: " << table.size() << std::endl;
+
+  // Mostly ASCII, with Latin-1, punctuation and missing glyphs
+  if (!run("Mixed text", corpus(80), iterations, map, table)) return 1;
+  // Whole lines of ASCII, as measured when rewrapping on resize
+  if (!run("ASCII lines", corpus(100), iterations, map, table)) return 1;
+
+  // Word at a time: ordinary words go straight to measure(), long ones are cached
+  if (!runWords("Mixed words", corpus(80), iterations, table)) return 1;
+  if (!runWords("Non-ASCII words", corpus(0), iterations, table)) return 1;
+  if (!runWords("Long words", longWords(), iterations, table)) return 1;
+  return 0;
+}
@@ -38,7 +38,7 @@ static constexpr int GLYPH_PADDING = 8;
 
 // Cache file format (must match main app)
 static constexpr uint32_t MSDF_CACHE_MAGIC = 0x4D534446;  // "MSDF"
-static constexpr uint32_t MSDF_CACHE_VERSION = 4;  // Match main app version
+static constexpr uint32_t MSDF_CACHE_VERSION = 5;  // Match main app version
 
 //=============================================================================
 // Data Structures
@@ -80,6 +80,32 @@ struct MSDFGlyph {
   bool valid = false;
 };
 
+// Cache file header, followed by the glyph table and, at pixelOffset, the
+// atlas rows (matches MSDFCacheHeader in the main app)
+struct CacheHeader {
+  uint32_t magic = MSDF_CACHE_MAGIC;
+  uint32_t version = MSDF_CACHE_VERSION;
+  uint64_t fontHash = 0;
+  int32_t atlasWidth = 0;
+  int32_t atlasHeight = 0;  // Only the rows glyphs were packed into
+  float pixelRange = 0;
+  float glyphSize = 0;
+  float ascent = 0;
+  float descent = 0;
+  float lineGap = 0;
+  uint32_t glyphCount = 0;
+  uint32_t compression = 0;  // Raw RGB rows
+  uint32_t reserved = 0;
+  uint64_t pixelOffset = 0;
+  uint64_t pixelBytes = 0;
+};
+static_assert(sizeof(CacheHeader) == 72, "Cache header must match the main app");
+
+struct CacheGlyph {
+  int32_t codepoint;
+  MSDFGlyph glyph;
+};
+
 //=============================================================================
 // OpenGL Helpers
 //=============================================================================
@@ -775,44 +801,61 @@ bool saveCacheFile(const std::string& fontPath, const std::string& cacheDir,
                    const FontAtlasData& data, const std::vector<uint8_t>& atlasPixels) {
   std::string cacheFile = cacheDir + "/" + getCacheFilename(fontPath);
   
-  std::ofstream file(cacheFile, std::ios::binary);
-  if (!file) {
-    std::cerr << "Failed to create cache file: " << cacheFile << std::endl;
-    return false;
+  // Only the rows glyphs were packed into are stored; texture coordinates are
+  // rescaled to the shorter atlas
+  int usedHeight = GLYPH_PADDING;
+  for (const auto& glyph : data.gpuGlyphs) {
+    usedHeight = std::max(usedHeight, glyph.atlasY + glyph.height + GLYPH_PADDING);
   }
-  
-  // Write header
-  uint32_t magic = MSDF_CACHE_MAGIC;
-  uint32_t version = MSDF_CACHE_VERSION;
-  uint64_t fontHash = computeFontFileHash(fontPath);
-  file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
-  file.write(reinterpret_cast<const char*>(&version), sizeof(version));
-  file.write(reinterpret_cast<const char*>(&fontHash), sizeof(fontHash));
-  
-  // Write atlas metadata
-  int atlasWidth = ATLAS_WIDTH;
-  int atlasHeight = ATLAS_HEIGHT;
-  float pixelRange = PIXEL_RANGE;
-  float glyphSize = GLYPH_SIZE;
-  file.write(reinterpret_cast<const char*>(&atlasWidth), sizeof(atlasWidth));
-  file.write(reinterpret_cast<const char*>(&atlasHeight), sizeof(atlasHeight));
-  file.write(reinterpret_cast<const char*>(&pixelRange), sizeof(pixelRange));
-  file.write(reinterpret_cast<const char*>(&glyphSize), sizeof(glyphSize));
-  file.write(reinterpret_cast<const char*>(&data.ascent), sizeof(data.ascent));
-  file.write(reinterpret_cast<const char*>(&data.descent), sizeof(data.descent));
-  file.write(reinterpret_cast<const char*>(&data.lineGap), sizeof(data.lineGap));
-  
-  // Write glyph count and data
-  uint32_t glyphCount = static_cast<uint32_t>(data.glyphInfo.size());
-  file.write(reinterpret_cast<const char*>(&glyphCount), sizeof(glyphCount));
-  for (const auto& [codepoint, glyph] : data.glyphInfo) {
-    int32_t cp = codepoint;
-    file.write(reinterpret_cast<const char*>(&cp), sizeof(cp));
-    file.write(reinterpret_cast<const char*>(&glyph), sizeof(glyph));
+  usedHeight = std::min(usedHeight, ATLAS_HEIGHT);
+  float vScale = (float)ATLAS_HEIGHT / usedHeight;
+  
+  std::vector<CacheGlyph> glyphs;
+  for (const auto& [codepoint, info] : data.glyphInfo) {
+    CacheGlyph entry{codepoint, info};
+    entry.glyph.v0 *= vScale;
+    entry.glyph.v1 *= vScale;
+    glyphs.push_back(entry);
   }
   
-  // Write atlas texture data (RGB)
-  file.write(reinterpret_cast<const char*>(atlasPixels.data()), atlasPixels.size());
+  CacheHeader header;
+  header.fontHash = computeFontFileHash(fontPath);
+  header.atlasWidth = ATLAS_WIDTH;
+  header.atlasHeight = usedHeight;
+  header.pixelRange = PIXEL_RANGE;
+  header.glyphSize = GLYPH_SIZE;
+  header.ascent = data.ascent;
+  header.descent = data.descent;
+  header.lineGap = data.lineGap;
+  header.glyphCount = static_cast<uint32_t>(glyphs.size());
+  uint64_t glyphsEnd = sizeof(CacheHeader) + glyphs.size() * sizeof(CacheGlyph);
+  header.pixelOffset = (glyphsEnd + 15) & ~uint64_t(15);
+  header.pixelBytes = static_cast<uint64_t>(ATLAS_WIDTH) * usedHeight * 3;
+  
+  // Written aside and renamed over the old cache, which the app may have mapped
+  std::string tempFile = cacheFile + ".tmp";
+  {
+    std::ofstream file(tempFile, std::ios::binary);
+    if (!file) {
+      std::cerr << "Failed to create cache file: " << cacheFile << std::endl;
+      return false;
+    }
+    const char zeros[16] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(glyphs.data()), glyphs.size() * sizeof(CacheGlyph));
+    file.write(zeros, header.pixelOffset - glyphsEnd);
+    file.write(reinterpret_cast<const char*>(atlasPixels.data()), header.pixelBytes);
+    if (!file) {
+      std::cerr << "Failed to write cache file: " << cacheFile << std::endl;
+      return false;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(tempFile, cacheFile, error);
+  if (error) {
+    std::cerr << "Failed to replace cache file: " << cacheFile << std::endl;
+    return false;
+  }
   
   std::cout << "Saved: " << std::filesystem::path(cacheFile).filename().string() << std::endl;
   return true;